@@ -31,7 +31,20 @@
 #include "sol/protected_function.hpp"
 #include "sol/state.hpp"
 #include "sol/coroutine.hpp"
+#include "sol/thread_pool.hpp"
+#include "sol/yielding.hpp"
+#include "sol/scheduler.hpp"
+#include "sol/coroutine_await.hpp"
+#include "sol/state_pool.hpp"
+#include "sol/transfer.hpp"
+#include "sol/channel.hpp"
+#include "sol/parallel_map.hpp"
 #include "sol/variadic_args.hpp"
+#include "sol/array_view.hpp"
+#include "sol/key_path.hpp"
+#include "sol/interned_key.hpp"
+#include "sol/fields.hpp"
+#include "sol/reference_arena.hpp"
 
 #include "sol/global_end.hpp"
 
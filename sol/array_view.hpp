@@ -0,0 +1,215 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_ARRAY_VIEW_HPP
+#define SOL_ARRAY_VIEW_HPP
+
+#include "stack.hpp"
+#include <iterator>
+
+namespace sol {
+
+	template <typename T>
+	struct array_view {
+	private:
+		lua_State* L;
+		int index;
+
+	public:
+		typedef T value_type;
+		typedef std::size_t size_type;
+
+		struct iterator {
+			typedef std::input_iterator_tag iterator_category;
+			typedef T value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef const T* pointer;
+			typedef T reference;
+
+			const array_view* view;
+			std::size_t i;
+
+			T operator*() const {
+				return (*view)[i];
+			}
+
+			iterator& operator++() {
+				++i;
+				return *this;
+			}
+
+			iterator operator++(int) {
+				iterator prev = *this;
+				++i;
+				return prev;
+			}
+
+			bool operator==(const iterator& right) const {
+				return i == right.i;
+			}
+
+			bool operator!=(const iterator& right) const {
+				return i != right.i;
+			}
+		};
+
+		array_view(lua_State* L, int index = -1) : L(L), index(lua_absindex(L, index)) {}
+
+		std::size_t size() const {
+			return static_cast<std::size_t>(lua_rawlen(L, index));
+		}
+
+		bool empty() const {
+			return size() == 0;
+		}
+
+		// 0-based, like the C++ containers it stands in for
+		T operator[](std::size_t i) const {
+			lua_rawgeti(L, index, static_cast<lua_Integer>(i + 1));
+			T value = stack::get<T>(L, -1);
+			lua_pop(L, 1);
+			return value;
+		}
+
+		iterator begin() const {
+			return iterator{ this, 0 };
+		}
+
+		iterator end() const {
+			return iterator{ this, size() };
+		}
+
+		int push() const {
+			lua_pushvalue(L, index);
+			return 1;
+		}
+
+		int stack_index() const {
+			return index;
+		}
+
+		lua_State* lua_state() const {
+			return L;
+		}
+	};
+
+	template <typename K, typename V>
+	struct table_view {
+	private:
+		lua_State* L;
+		int index;
+
+	public:
+		typedef K key_type;
+		typedef V mapped_type;
+
+		table_view(lua_State* L, int index = -1) : L(L), index(lua_absindex(L, index)) {}
+
+		template <typename Key>
+		V operator[](Key&& key) const {
+			stack::push(L, std::forward<Key>(key));
+			lua_rawget(L, index);
+			V value = stack::get<V>(L, -1);
+			lua_pop(L, 1);
+			return value;
+		}
+
+		template <typename Key>
+		optional<V> get(Key&& key) const {
+			stack::push(L, std::forward<Key>(key));
+			lua_rawget(L, index);
+			optional<V> value = stack::check_get<V>(L, -1);
+			lua_pop(L, 1);
+			return value;
+		}
+
+		template <typename Fx>
+		void for_each(Fx&& fx) const {
+			lua_pushnil(L);
+			while (lua_next(L, index) != 0) {
+				// convert a copy of the key, so string conversions cannot confuse lua_next
+				lua_pushvalue(L, -2);
+				fx(stack::get<K>(L, -1), stack::get<V>(L, -2));
+				lua_pop(L, 2);
+			}
+		}
+
+		int push() const {
+			lua_pushvalue(L, index);
+			return 1;
+		}
+
+		int stack_index() const {
+			return index;
+		}
+
+		lua_State* lua_state() const {
+			return L;
+		}
+	};
+
+	template <typename T>
+	struct is_container<array_view<T>> : std::false_type {};
+
+	namespace detail {
+		template <typename T>
+		struct lua_type_of<array_view<T>> : std::integral_constant<type, type::table> {};
+
+		template <typename K, typename V>
+		struct lua_type_of<table_view<K, V>> : std::integral_constant<type, type::table> {};
+	} // detail
+
+	namespace stack {
+		template <typename T>
+		struct getter<array_view<T>> {
+			static array_view<T> get(lua_State* L, int index, record& tracking) {
+				tracking.use(1);
+				return array_view<T>(L, index);
+			}
+		};
+
+		template <typename K, typename V>
+		struct getter<table_view<K, V>> {
+			static table_view<K, V> get(lua_State* L, int index, record& tracking) {
+				tracking.use(1);
+				return table_view<K, V>(L, index);
+			}
+		};
+
+		template <typename T>
+		struct pusher<array_view<T>> {
+			static int push(lua_State*, const array_view<T>& view) {
+				return view.push();
+			}
+		};
+
+		template <typename K, typename V>
+		struct pusher<table_view<K, V>> {
+			static int push(lua_State*, const table_view<K, V>& view) {
+				return view.push();
+			}
+		};
+	} // stack
+
+} // sol
+
+#endif // SOL_ARRAY_VIEW_HPP
@@ -0,0 +1,96 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_BUFFER_HPP
+#define SOL_BUFFER_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+#include <array>
+
+namespace sol {
+	template <typename T>
+	struct buffer {
+		typedef T value_type;
+		typedef T& reference;
+		typedef const T& const_reference;
+		typedef T* pointer;
+		typedef T* iterator;
+		typedef const T* const_iterator;
+		typedef std::size_t size_type;
+		typedef std::ptrdiff_t difference_type;
+
+		T* first;
+		std::size_t count;
+
+		buffer() : first(nullptr), count(0) {}
+		buffer(T* first, std::size_t count) : first(first), count(count) {}
+		buffer(T* first, T* last) : first(first), count(static_cast<std::size_t>(last - first)) {}
+
+		T* data() const {
+			return first;
+		}
+
+		std::size_t size() const {
+			return count;
+		}
+
+		bool empty() const {
+			return count == 0;
+		}
+
+		T* begin() const {
+			return first;
+		}
+
+		T* end() const {
+			return first + count;
+		}
+
+		T& operator[](std::size_t i) const {
+			return first[i];
+		}
+	};
+
+	template <typename T>
+	buffer<T> make_buffer(T* first, std::size_t count) {
+		return buffer<T>(first, count);
+	}
+
+	template <typename T, typename Al>
+	buffer<T> make_buffer(std::vector<T, Al>& source) {
+		return buffer<T>(source.data(), source.size());
+	}
+
+	template <typename T, std::size_t N>
+	buffer<T> make_buffer(std::array<T, N>& source) {
+		return buffer<T>(source.data(), N);
+	}
+
+	template <typename T, std::size_t N>
+	buffer<T> make_buffer(T(&source)[N]) {
+		return buffer<T>(source, N);
+	}
+} // sol
+
+#endif // SOL_BUFFER_HPP
@@ -0,0 +1,380 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_CHANNEL_HPP
+#define SOL_CHANNEL_HPP
+
+#include "serialize.hpp"
+#include "object.hpp"
+#include "optional.hpp"
+#include "error.hpp"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <cstdint>
+
+namespace sol {
+	namespace detail {
+		// A bounded multi-producer multi-consumer ring of encoded messages.
+		// Every cell has a sequence number that says whose turn it is, so senders and
+		// receivers only ever race on one atomic increment, and never take a lock.
+		class channel_queue {
+		private:
+			struct cell {
+				std::atomic<std::size_t> sequence;
+				std::string data;
+			};
+
+			std::unique_ptr<cell[]> cells;
+			std::size_t mask;
+			alignas(64) std::atomic<std::size_t> send_position;
+			alignas(64) std::atomic<std::size_t> receive_position;
+
+			cell* claim(std::size_t& position) {
+				position = send_position.load(std::memory_order_relaxed);
+				for (;;) {
+					cell* target = &cells[position & mask];
+					std::size_t sequence = target->sequence.load(std::memory_order_acquire);
+					std::intptr_t difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+					if (difference == 0) {
+						if (send_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+							return target;
+						}
+					}
+					else if (difference < 0) {
+						return nullptr;
+					}
+					else {
+						position = send_position.load(std::memory_order_relaxed);
+					}
+				}
+			}
+
+		public:
+			channel_queue(std::size_t capacity) : send_position(0), receive_position(0) {
+				std::size_t size = 2;
+				while (size < capacity) {
+					size <<= 1;
+				}
+				cells.reset(new cell[size]);
+				mask = size - 1;
+				for (std::size_t i = 0; i < size; ++i) {
+					cells[i].sequence.store(i, std::memory_order_relaxed);
+				}
+			}
+
+			bool try_push(std::string& message) {
+				std::size_t position;
+				cell* target = claim(position);
+				if (target == nullptr) {
+					return false;
+				}
+				target->data.swap(message);
+				target->sequence.store(position + 1, std::memory_order_release);
+				return true;
+			}
+
+			bool try_push(const char* data, std::size_t size) {
+				std::size_t position;
+				cell* target = claim(position);
+				if (target == nullptr) {
+					return false;
+				}
+				target->data.assign(data, size);
+				target->sequence.store(position + 1, std::memory_order_release);
+				return true;
+			}
+
+			bool try_pop(std::string& message) {
+				std::size_t position = receive_position.load(std::memory_order_relaxed);
+				cell* source;
+				for (;;) {
+					source = &cells[position & mask];
+					std::size_t sequence = source->sequence.load(std::memory_order_acquire);
+					std::intptr_t difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+					if (difference == 0) {
+						if (receive_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+							break;
+						}
+					}
+					else if (difference < 0) {
+						return false;
+					}
+					else {
+						position = receive_position.load(std::memory_order_relaxed);
+					}
+				}
+				message.swap(source->data);
+				source->data.clear();
+				source->sequence.store(position + mask + 1, std::memory_order_release);
+				return true;
+			}
+
+			std::size_t size() const {
+				std::size_t sent = send_position.load(std::memory_order_relaxed);
+				std::size_t received = receive_position.load(std::memory_order_relaxed);
+				return sent > received ? sent - received : 0;
+			}
+
+			std::size_t capacity() const {
+				return mask + 1;
+			}
+		};
+
+		inline bool can_yield(lua_State* L) {
+#if SOL_LUA_VERSION >= 503
+			return lua_isyieldable(L) != 0;
+#else
+			(void)L;
+			return false;
+#endif // only 5.3+ can tell, and 5.1 has no continuations
+		}
+	} // detail
+
+	class channel {
+	private:
+		std::shared_ptr<detail::channel_queue> queue;
+
+		static channel& self(lua_State* L) {
+			void* data = luaL_checkudata(L, 1, &usertype_traits<channel>::metatable()[0]);
+			return **static_cast<channel**>(data);
+		}
+
+		// leaves the encoded value on top of the stack as a string, so nothing on the C++ side owns it
+		// across a yield and no destructor is skipped when the error below is raised
+		static void encode(lua_State* L, int index) {
+			const char* err;
+			{
+				std::string message;
+				err = detail::binary_writer(L, message).write(index);
+				if (err == nullptr) {
+					lua_pushlstring(L, message.data(), message.size());
+				}
+			}
+			if (err != nullptr) {
+				luaL_error(L, "%s", err);
+			}
+		}
+
+		// replaces the encoded string on top of the stack with the value it holds
+		static void decode(lua_State* L) {
+			std::size_t size;
+			const char* data = lua_tolstring(L, -1, &size);
+			const char* err = detail::binary_decode(L, data, size);
+			if (err != nullptr) {
+				luaL_error(L, "%s", err);
+			}
+			lua_remove(L, -2);
+		}
+
+		static bool pop_payload(lua_State* L, channel& ch) {
+			std::string message;
+			if (!ch.queue->try_pop(message)) {
+				return false;
+			}
+			lua_pushlstring(L, message.data(), message.size());
+			return true;
+		}
+
+		static int lua_try_send_call(lua_State* L) {
+			channel& ch = self(L);
+			lua_settop(L, 2);
+			encode(L, 2);
+			std::size_t size;
+			const char* data = lua_tolstring(L, 3, &size);
+			lua_pushboolean(L, ch.queue->try_push(data, size));
+			return 1;
+		}
+
+		static int lua_try_receive_call(lua_State* L) {
+			channel& ch = self(L);
+			lua_settop(L, 1);
+			if (!pop_payload(L, ch)) {
+				lua_pushboolean(L, 0);
+				return 1;
+			}
+			decode(L);
+			lua_pushboolean(L, 1);
+			lua_insert(L, -2);
+			return 2;
+		}
+
+		// the encoded message waits at index 3 while the sender is suspended
+		static int lua_send_payload(lua_State* L) {
+			channel& ch = self(L);
+			std::size_t size;
+			const char* data = lua_tolstring(L, 3, &size);
+			while (!ch.queue->try_push(data, size)) {
+#if SOL_LUA_VERSION >= 503
+				if (detail::can_yield(L)) {
+					// try again when the coroutine is resumed
+					lua_settop(L, 3);
+					return lua_yieldk(L, 0, 0, &lua_send_continue);
+				}
+#endif // continuations
+				std::this_thread::yield();
+			}
+			return 0;
+		}
+
+		static int lua_send_call(lua_State* L) {
+			self(L);
+			lua_settop(L, 2);
+			encode(L, 2);
+			return lua_send_payload(L);
+		}
+
+		static int lua_receive_call(lua_State* L) {
+			channel& ch = self(L);
+			lua_settop(L, 1);
+			while (!pop_payload(L, ch)) {
+#if SOL_LUA_VERSION >= 503
+				if (detail::can_yield(L)) {
+					return lua_yieldk(L, 0, 0, &lua_receive_continue);
+				}
+#endif // continuations
+				std::this_thread::yield();
+			}
+			decode(L);
+			return 1;
+		}
+
+#if SOL_LUA_VERSION >= 503
+		static int lua_send_continue(lua_State* L, int, lua_KContext) {
+			return detail::static_trampoline<&lua_send_payload>(L);
+		}
+
+		static int lua_receive_continue(lua_State* L, int, lua_KContext) {
+			return detail::static_trampoline<&lua_receive_call>(L);
+		}
+#endif // continuations
+
+		static int lua_send(lua_State* L) {
+			return detail::static_trampoline<&lua_send_call>(L);
+		}
+
+		static int lua_try_send(lua_State* L) {
+			return detail::static_trampoline<&lua_try_send_call>(L);
+		}
+
+		static int lua_receive(lua_State* L) {
+			return detail::static_trampoline<&lua_receive_call>(L);
+		}
+
+		static int lua_try_receive(lua_State* L) {
+			return detail::static_trampoline<&lua_try_receive_call>(L);
+		}
+
+		static int lua_size(lua_State* L) {
+			lua_pushinteger(L, static_cast<lua_Integer>(self(L).size()));
+			return 1;
+		}
+
+	public:
+		explicit channel(std::size_t capacity = 1024) : queue(std::make_shared<detail::channel_queue>(capacity)) {}
+
+		bool try_send(const object& value) {
+			lua_State* L = value.lua_state();
+			detail::settop_on_exit restore{ L, lua_gettop(L) };
+			value.push();
+			std::string message;
+			const char* err = detail::binary_writer(L, message).write(-1);
+			if (err != nullptr) {
+#ifndef SOL_NO_EXCEPTIONS
+				throw error(err);
+#else
+				return false;
+#endif // No Exceptions
+			}
+			return queue->try_push(message);
+		}
+
+		optional<object> try_receive(lua_State* L) {
+			std::string message;
+			if (!queue->try_pop(message)) {
+				return nullopt;
+			}
+			const char* err = detail::binary_decode(L, message.data(), message.size());
+			if (err != nullptr) {
+#ifndef SOL_NO_EXCEPTIONS
+				throw error(err);
+#else
+				return nullopt;
+#endif // No Exceptions
+			}
+			return stack::pop<object>(L);
+		}
+
+		std::size_t size() const {
+			return queue->size();
+		}
+
+		std::size_t capacity() const {
+			return queue->capacity();
+		}
+
+		bool operator==(const channel& right) const {
+			return queue == right.queue;
+		}
+
+		bool operator!=(const channel& right) const {
+			return queue != right.queue;
+		}
+
+		static void push_metatable(lua_State* L) {
+			static const luaL_Reg functions[] = {
+				{ "send", &lua_send },
+				{ "try_send", &lua_try_send },
+				{ "receive", &lua_receive },
+				{ "try_receive", &lua_try_receive },
+				{ "size", &lua_size },
+				{ nullptr, nullptr }
+			};
+			if (luaL_newmetatable(L, &usertype_traits<channel>::metatable()[0]) == 0) {
+				return;
+			}
+			lua_pushcfunction(L, &detail::usertype_alloc_destroy<channel>);
+			lua_setfield(L, -2, "__gc");
+			lua_createtable(L, 0, 5);
+			for (const luaL_Reg* f = functions; f->name != nullptr; ++f) {
+				lua_pushcfunction(L, f->func);
+				lua_setfield(L, -2, f->name);
+			}
+			lua_setfield(L, -2, "__index");
+		}
+	};
+
+	namespace stack {
+		template <>
+		struct pusher<channel> {
+			static int push(lua_State* L, const channel& ch) {
+				return pusher<detail::as_value_tag<channel>>{}.push_fx(L, [L]() {
+					channel::push_metatable(L);
+					lua_setmetatable(L, -2);
+				}, ch);
+			}
+		};
+	} // stack
+} // sol
+
+#endif // SOL_CHANNEL_HPP
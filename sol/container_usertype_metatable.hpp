@@ -23,7 +23,9 @@
 #define SOL_CONTAINER_USERTYPE_HPP
 
 #include "stack.hpp"
+#include "buffer.hpp"
 #include <algorithm>
+#include <functional>
 #include <unordered_map>
 
 namespace sol {
@@ -82,6 +84,94 @@ namespace sol {
 			static const bool value = sizeof(test<T>(0)) == sizeof(char);
 		};
 
+		template <typename T>
+		struct has_data {
+		private:
+			typedef std::array<char, 1> one;
+			typedef std::array<char, 2> two;
+
+			template <typename C> static one test(decltype(std::declval<C>().data())*);
+			template <typename C> static two test(...);
+
+		public:
+			static const bool value = sizeof(test<T>(0)) == sizeof(char);
+		};
+
+		// The bulk kernels keep several independent accumulators so the
+		// loops vectorize without needing the compiler to reassociate floating point math
+		template <typename T>
+		using buffer_accumulator_t = std::conditional_t<std::is_integral<T>::value, long long, T>;
+
+		template <typename T>
+		buffer_accumulator_t<T> buffer_sum(const T* p, std::size_t n) {
+			typedef buffer_accumulator_t<T> A;
+			A a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+			std::size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				a0 += p[i];
+				a1 += p[i + 1];
+				a2 += p[i + 2];
+				a3 += p[i + 3];
+			}
+			for (; i < n; ++i) {
+				a0 += p[i];
+			}
+			return (a0 + a1) + (a2 + a3);
+		}
+
+		template <typename T>
+		buffer_accumulator_t<T> buffer_dot(const T* p, const T* q, std::size_t n) {
+			typedef buffer_accumulator_t<T> A;
+			A a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+			std::size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				a0 += static_cast<A>(p[i]) * q[i];
+				a1 += static_cast<A>(p[i + 1]) * q[i + 1];
+				a2 += static_cast<A>(p[i + 2]) * q[i + 2];
+				a3 += static_cast<A>(p[i + 3]) * q[i + 3];
+			}
+			for (; i < n; ++i) {
+				a0 += static_cast<A>(p[i]) * q[i];
+			}
+			return (a0 + a1) + (a2 + a3);
+		}
+
+		template <typename T>
+		void buffer_scale(T* p, std::size_t n, T s) {
+			for (std::size_t i = 0; i < n; ++i) {
+				p[i] *= s;
+			}
+		}
+
+		template <typename T>
+		void buffer_accumulate(T* p, const T* q, std::size_t n, T s) {
+			for (std::size_t i = 0; i < n; ++i) {
+				p[i] += q[i] * s;
+			}
+		}
+
+		template <typename T, typename Compare>
+		T buffer_extreme(const T* p, std::size_t n, Compare c) {
+			T r = p[0];
+			for (std::size_t i = 1; i < n; ++i) {
+				r = c(p[i], r) ? p[i] : r;
+			}
+			return r;
+		}
+
+		// Numeric containers and buffers keep one of these in their metatable, under a key named after their value_type,
+		// so dot and accumulate can read any other contiguous source of the same element type
+		template <typename T>
+		struct contiguous_source {
+			buffer<const T> (*view)(lua_State*, int);
+		};
+
+		template <typename T>
+		inline const std::string& contiguous_source_key() {
+			static const std::string k = std::string("sol.").append(demangle<T>()).append(".contiguous");
+			return k;
+		}
+
 		template <typename T>
 		T& get_first(const T& t) {
 			return std::forward<T>(t);
@@ -125,6 +215,20 @@ namespace sol {
 				decltype(*std::declval<I&>())
 			>
 		> push_type;
+		typedef meta::all<
+			is_proxied_container<T>,
+			meta::neg<is_associative>,
+			std::is_lvalue_reference<push_type>,
+			meta::neg<std::is_const<std::remove_reference_t<push_type>>>,
+			meta::neg<is_lua_primitive<V>>,
+			meta::neg<is_unique_usertype<V>>
+		> is_element_proxied;
+		typedef meta::all<
+			std::is_arithmetic<V>,
+			meta::neg<is_associative>,
+			std::integral_constant<bool, detail::has_data<T>::value>
+		> is_numeric_buffer;
+		typedef meta::all<is_numeric_buffer, meta::neg<std::is_const<IR>>> is_mutable_numeric_buffer;
 
 		struct iter {
 			T& source;
@@ -145,13 +249,56 @@ namespace sol {
 #endif // Safe getting with error
 		}
 
+		static void push_element_cache(lua_State* L, int holder, std::size_t sizehint) {
+			lua_getuservalue(L, holder);
+			if (type_of(L, -1) == type::table) {
+				return;
+			}
+			lua_pop(L, 1);
+			lua_createtable(L, static_cast<int>(sizehint), 0);
+			lua_pushvalue(L, -1);
+			lua_setuservalue(L, holder);
+		}
+
+		template <typename E>
+		static int push_element(std::false_type, lua_State* L, int, std::size_t, std::size_t, E&& e) {
+			return stack::stack_detail::push_reference<push_type>(L, std::forward<E>(e));
+		}
+
+		template <typename E>
+		static int push_element(std::true_type, lua_State* L, int holder, std::size_t sizehint, std::size_t k, E&& e) {
+			// Elements are handed out as one pointer userdata per index, stored in the holder's user value:
+			// later accesses re-point the cached userdata at the element instead of allocating a new one
+			push_element_cache(L, holder, sizehint);
+			lua_rawgeti(L, -1, static_cast<lua_Integer>(k));
+			if (type_of(L, -1) == type::userdata) {
+				V** pref = static_cast<V**>(lua_touserdata(L, -1));
+				*pref = std::addressof(e);
+			}
+			else {
+				lua_pop(L, 1);
+				stack::stack_detail::push_reference<push_type>(L, std::forward<E>(e));
+				lua_pushvalue(L, -1);
+				lua_rawseti(L, -3, static_cast<lua_Integer>(k));
+			}
+			lua_remove(L, -2);
+			return 1;
+		}
+
 		static int delegate_call(lua_State* L) {
 			static std::unordered_map<std::string, lua_CFunction> calls{
 				{ "add", &real_add_call },
 				{ "insert", &real_insert_call },
 				{ "clear", &real_clear_call },
 				{ "find", &real_find_call },
-				{ "get", &real_get_call }
+				{ "get", &real_get_call },
+				{ "sum", &real_sum_call },
+				{ "dot", &real_dot_call },
+				{ "scale", &real_scale_call },
+				{ "accumulate", &real_accumulate_call },
+				{ "min", &real_min_call },
+				{ "max", &real_max_call },
+				{ "fill", &real_fill_call }
 			};
 			auto maybename = stack::check_get<std::string>(L, 2);
 			if (maybename) {
@@ -191,9 +338,8 @@ namespace sol {
 				if (k > src.size() || k < 1) {
 					return stack::push(L, lua_nil);
 				}
-				--k;
-				std::advance(it, k);
-				return stack::stack_detail::push_reference<push_type>(L, *it);
+				std::advance(it, k - 1);
+				return push_element(is_element_proxied(), L, 1, src.size(), static_cast<std::size_t>(k), *it);
 			}
 			else {
 				return delegate_call(L);
@@ -340,7 +486,7 @@ namespace sol {
 			}
 			int p;
 			p = stack::push_reference(L, k + 1);
-			p += stack::stack_detail::push_reference<push_type>(L, *it);
+			p += push_element(is_element_proxied(), L, 1, source.size(), static_cast<std::size_t>(k + 1), *it);
 			std::advance(it, 1);
 			return p;
 		}
@@ -350,6 +496,11 @@ namespace sol {
 			using std::begin;
 			stack::push(L, pairs_next_call);
 			stack::push<user<iter>>(L, src, begin(src));
+			if (is_element_proxied::value) {
+				// share the container's element cache with the iterator
+				push_element_cache(L, 1, src.size());
+				lua_setuservalue(L, -2);
+			}
 			stack::push(L, 0);
 			return 3;
 		}
@@ -478,6 +629,146 @@ namespace sol {
 			return real_find_call_capable(std::integral_constant<bool, detail::has_find<T>::value>(), is_associative(), L);
 		}
 
+		typedef std::remove_cv_t<V> element_t;
+
+		static buffer<const element_t> contiguous_view(lua_State* L, int index) {
+			T& src = *stack::get<T*>(L, index);
+			return buffer<const element_t>(src.data(), src.size());
+		}
+
+		static buffer<const element_t> get_other(lua_State* L, int index, std::size_t size) {
+			buffer<const element_t> other;
+			bool found = false;
+			if (lua_getmetatable(L, index) == 1) {
+				const std::string& key = detail::contiguous_source_key<element_t>();
+				lua_pushlstring(L, key.c_str(), key.size());
+				lua_rawget(L, -2);
+				if (type_of(L, -1) == type::lightuserdata) {
+					auto source = static_cast<const detail::contiguous_source<element_t>*>(lua_touserdata(L, -1));
+					other = source->view(L, index);
+					found = true;
+				}
+				lua_pop(L, 2);
+			}
+			if (!found) {
+				luaL_error(L, "sol: argument %d is not a contiguous container of %s", index, detail::demangle<element_t>().c_str());
+			}
+			if (other.size() != size) {
+				luaL_error(L, "sol: argument %d has a different size than 'self' (%d vs. %d)", index, static_cast<int>(other.size()), static_cast<int>(size));
+			}
+			return other;
+		}
+
+		static int real_sum_call_capable(std::false_type, lua_State* L) {
+			static const std::string& s = detail::demangle<T>();
+			return luaL_error(L, "sol: cannot call sum on type %s", s.c_str());
+		}
+
+		static int real_sum_call_capable(std::true_type, lua_State* L) {
+			auto& src = get_src(L);
+			return stack::push(L, detail::buffer_sum(src.data(), src.size()));
+		}
+
+		static int real_sum_call(lua_State* L) {
+			return real_sum_call_capable(is_numeric_buffer(), L);
+		}
+
+		static int real_dot_call_capable(std::false_type, lua_State* L) {
+			static const std::string& s = detail::demangle<T>();
+			return luaL_error(L, "sol: cannot call dot on type %s", s.c_str());
+		}
+
+		static int real_dot_call_capable(std::true_type, lua_State* L) {
+			auto& src = get_src(L);
+			auto other = get_other(L, 2, src.size());
+			return stack::push(L, detail::buffer_dot(src.data(), other.data(), src.size()));
+		}
+
+		static int real_dot_call(lua_State* L) {
+			return real_dot_call_capable(is_numeric_buffer(), L);
+		}
+
+		static int real_scale_call_capable(std::false_type, lua_State* L) {
+			static const std::string& s = detail::demangle<T>();
+			return luaL_error(L, "sol: cannot call scale on type %s", s.c_str());
+		}
+
+		static int real_scale_call_capable(std::true_type, lua_State* L) {
+			auto& src = get_src(L);
+			detail::buffer_scale(src.data(), src.size(), stack::get<V>(L, 2));
+			return 0;
+		}
+
+		static int real_scale_call(lua_State* L) {
+			return real_scale_call_capable(is_mutable_numeric_buffer(), L);
+		}
+
+		static int real_accumulate_call_capable(std::false_type, lua_State* L) {
+			static const std::string& s = detail::demangle<T>();
+			return luaL_error(L, "sol: cannot call accumulate on type %s", s.c_str());
+		}
+
+		static int real_accumulate_call_capable(std::true_type, lua_State* L) {
+			auto& src = get_src(L);
+			auto other = get_other(L, 2, src.size());
+			V scale = type_of(L, 3) == type::none || type_of(L, 3) == type::nil ? static_cast<V>(1) : stack::get<V>(L, 3);
+			detail::buffer_accumulate(src.data(), other.data(), src.size(), scale);
+			return 0;
+		}
+
+		static int real_accumulate_call(lua_State* L) {
+			return real_accumulate_call_capable(is_mutable_numeric_buffer(), L);
+		}
+
+		static int real_min_call_capable(std::false_type, lua_State* L) {
+			static const std::string& s = detail::demangle<T>();
+			return luaL_error(L, "sol: cannot call min on type %s", s.c_str());
+		}
+
+		static int real_min_call_capable(std::true_type, lua_State* L) {
+			auto& src = get_src(L);
+			if (src.size() < 1) {
+				return stack::push(L, lua_nil);
+			}
+			return stack::push(L, detail::buffer_extreme(src.data(), src.size(), std::less<V>()));
+		}
+
+		static int real_min_call(lua_State* L) {
+			return real_min_call_capable(is_numeric_buffer(), L);
+		}
+
+		static int real_max_call_capable(std::false_type, lua_State* L) {
+			static const std::string& s = detail::demangle<T>();
+			return luaL_error(L, "sol: cannot call max on type %s", s.c_str());
+		}
+
+		static int real_max_call_capable(std::true_type, lua_State* L) {
+			auto& src = get_src(L);
+			if (src.size() < 1) {
+				return stack::push(L, lua_nil);
+			}
+			return stack::push(L, detail::buffer_extreme(src.data(), src.size(), std::greater<V>()));
+		}
+
+		static int real_max_call(lua_State* L) {
+			return real_max_call_capable(is_numeric_buffer(), L);
+		}
+
+		static int real_fill_call_capable(std::false_type, lua_State* L) {
+			static const std::string& s = detail::demangle<T>();
+			return luaL_error(L, "sol: cannot call fill on type %s", s.c_str());
+		}
+
+		static int real_fill_call_capable(std::true_type, lua_State* L) {
+			auto& src = get_src(L);
+			std::fill_n(src.data(), src.size(), stack::get<V>(L, 2));
+			return 0;
+		}
+
+		static int real_fill_call(lua_State* L) {
+			return real_fill_call_capable(is_mutable_numeric_buffer(), L);
+		}
+
 		static int add_call(lua_State*L) {
 			return detail::typed_static_trampoline<decltype(&real_add_call), (&real_add_call)>(L);
 		}
@@ -552,6 +843,20 @@ namespace sol {
 				return reg;
 			}
 
+			template <typename T>
+			inline void set_contiguous_source(std::false_type, lua_State*, int) {}
+
+			template <typename T>
+			inline void set_contiguous_source(std::true_type, lua_State* L, int metatableindex) {
+				typedef container_usertype_metatable<std::remove_pointer_t<T>> meta_cumt;
+				typedef typename meta_cumt::element_t E;
+				static const detail::contiguous_source<E> source{ &meta_cumt::contiguous_view };
+				const std::string& key = detail::contiguous_source_key<E>();
+				lua_pushlstring(L, key.c_str(), key.size());
+				lua_pushlightuserdata(L, const_cast<detail::contiguous_source<E>*>(&source));
+				lua_rawset(L, metatableindex);
+			}
+
 			template <typename T>
 			struct metatable_setup {
 				lua_State* L;
@@ -566,6 +871,7 @@ namespace sol {
 					if (luaL_newmetatable(L, metakey) == 1) {
 						stack_reference metatable(L, -1);
 						luaL_setfuncs(L, reg.data(), 0);
+						set_contiguous_source<T>(typename container_usertype_metatable<std::remove_pointer_t<T>>::is_numeric_buffer(), L, metatable.stack_index());
 
 						lua_createtable(L, 0, static_cast<int>(containerreg.size()));
 						stack_reference metabehind(L, -1);
@@ -26,6 +26,7 @@
 #include "stack.hpp"
 #include "function_result.hpp"
 #include "thread.hpp"
+#include "execution_limit.hpp"
 
 namespace sol {
 	class coroutine : public reference {
@@ -33,11 +34,19 @@ namespace sol {
 		call_status stats = call_status::yielded;
 
 		void luacall(std::ptrdiff_t argcount, std::ptrdiff_t) {
+			detail::limit_scope ls(lua_state(), limit, true);
 #if SOL_LUA_VERSION < 502
 			stats = static_cast<call_status>(lua_resume(lua_state(), static_cast<int>(argcount)));
 #else
 			stats = static_cast<call_status>(lua_resume(lua_state(), nullptr, static_cast<int>(argcount)));
 #endif // Lua 5.1 compat
+			if (ls.exceeded() && (stats == call_status::yielded || stats == call_status::runtime)) {
+				stats = call_status::timeout;
+			}
+		}
+
+		bool suspended() const noexcept {
+			return lua_status(lua_state()) == LUA_YIELD;
 		}
 
 		template<std::size_t... I, typename... Ret>
@@ -70,6 +79,8 @@ namespace sol {
 		}
 
 	public:
+		execution_limit limit;
+
 		coroutine() noexcept = default;
 		coroutine(const coroutine&) noexcept = default;
 		coroutine(coroutine&&) noexcept = default;
@@ -100,12 +111,12 @@ namespace sol {
 
 		bool error() const noexcept {
 			call_status cs = status();
-			return cs != call_status::ok && cs != call_status::yielded;
+			return cs != call_status::ok && cs != call_status::yielded && !(cs == call_status::timeout && suspended());
 		}
 
 		bool runnable() const noexcept {
 			return valid()
-				&& (status() == call_status::yielded);
+				&& (status() == call_status::yielded || (status() == call_status::timeout && suspended()));
 		}
 
 		explicit operator bool() const noexcept {
@@ -0,0 +1,105 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_COROUTINE_AWAIT_HPP
+#define SOL_COROUTINE_AWAIT_HPP
+
+#include "feature_test.hpp"
+
+#ifdef SOL_CXX20_COROUTINES
+
+#include "coroutine.hpp"
+#include "scheduler.hpp"
+#include <coroutine>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace sol {
+
+	// resumes the Lua coroutine synchronously, inside co_await: the awaiting coroutine is never suspended
+	template <typename... Args>
+	class resume_awaiter {
+	private:
+		coroutine& co;
+		// copies, so an awaiter kept past the full expression that made it does not dangle
+		std::tuple<Args...> args;
+
+	public:
+		template <typename... In>
+		resume_awaiter(coroutine& co, In&&... in) : co(co), args(std::forward<In>(in)...) {}
+
+		bool await_ready() const noexcept {
+			// resuming a Lua coroutine never blocks: it runs until it yields or returns
+			return true;
+		}
+
+		void await_suspend(std::coroutine_handle<>) const noexcept {}
+
+		protected_function_result await_resume() {
+			return std::apply([this](auto&&... a) { return co(std::move(a)...); }, args);
+		}
+	};
+
+	template <typename... Args>
+	resume_awaiter<std::decay_t<Args>...> resume(coroutine& co, Args&&... args) {
+		return resume_awaiter<std::decay_t<Args>...>(co, std::forward<Args>(args)...);
+	}
+
+	class join_awaiter {
+	private:
+		scheduler& sched;
+		task_id id;
+		task_result result;
+
+	public:
+		join_awaiter(scheduler& sched, task_id id) : sched(sched), id(id) {
+			// stays this way if the task is already gone by the time it is awaited:
+			// it may have finished, failed or been cancelled, and the scheduler no longer knows which
+			result.unknown = true;
+		}
+
+		bool await_ready() const {
+			return !sched.alive(id);
+		}
+
+		bool await_suspend(std::coroutine_handle<> handle) {
+			return sched.on_finish(id, [this, handle](const task_result& r) {
+				result = r;
+				handle.resume();
+			});
+		}
+
+		task_result await_resume() {
+			return std::move(result);
+		}
+	};
+
+	inline join_awaiter join(scheduler& sched, task_id id) {
+		return join_awaiter(sched, id);
+	}
+
+} // sol
+
+#endif // C++20 coroutines
+
+#endif // SOL_COROUTINE_AWAIT_HPP
@@ -0,0 +1,192 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_EXECUTION_LIMIT_HPP
+#define SOL_EXECUTION_LIMIT_HPP
+
+#include "types.hpp"
+#include <chrono>
+#include <cstddef>
+
+namespace sol {
+	struct execution_limit {
+		typedef std::chrono::steady_clock clock;
+
+		std::size_t instructions = 0;
+		clock::duration time = clock::duration::zero();
+		int granularity = 1000;
+
+		execution_limit() = default;
+		execution_limit(std::size_t instructions, int granularity = 1000) : instructions(instructions), granularity(granularity) {}
+		template <typename Rep, typename Period>
+		execution_limit(std::chrono::duration<Rep, Period> time, std::size_t instructions = 0, int granularity = 1000) : instructions(instructions), time(std::chrono::duration_cast<clock::duration>(time)), granularity(granularity) {}
+
+		bool active() const {
+			return instructions != 0 || time != clock::duration::zero();
+		}
+	};
+
+	namespace detail {
+		struct limit_state {
+			lua_State* L;
+			lua_State* main;
+			limit_state* previous;
+			std::size_t remaining;
+			int step;
+			bool counted;
+			bool timed;
+			bool yields;
+			bool exceeded;
+			execution_limit::clock::time_point deadline;
+		};
+
+		inline limit_state*& current_limit() {
+			static thread_local limit_state* s = nullptr;
+			return s;
+		}
+
+		inline lua_State* limit_main_thread(lua_State* L) {
+#if SOL_LUA_VERSION >= 502
+			lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+			lua_State* main = lua_tothread(L, -1);
+			lua_pop(L, 1);
+			return main;
+#else
+			(void)L;
+			return nullptr;
+#endif // Lua 5.2+ has the main thread in the registry
+		}
+
+		inline limit_state* find_limit(lua_State* L) {
+			for (limit_state* s = current_limit(); s != nullptr; s = s->previous) {
+				if (s->L == L) {
+					return s;
+				}
+			}
+			// coroutines started inside a limited call inherit its hook, so they answer
+			// to the innermost limit of the same Lua state (on 5.1, to the innermost limit)
+			lua_State* main = limit_main_thread(L);
+			for (limit_state* s = current_limit(); s != nullptr; s = s->previous) {
+				if (s->main == main) {
+					return s;
+				}
+			}
+			return nullptr;
+		}
+
+		inline void limit_hook(lua_State* L, lua_Debug*) {
+			limit_state* s = find_limit(L);
+			if (s == nullptr) {
+				// a coroutine that outlived the call it was created in: stop checking on every instruction
+				if (lua_gethookcount(L) == 1) {
+					lua_sethook(L, &limit_hook, LUA_MASKCOUNT, execution_limit().granularity);
+				}
+				return;
+			}
+			if (!s->exceeded) {
+				bool out = false;
+				if (s->counted) {
+					std::size_t step = static_cast<std::size_t>(s->step);
+					out = s->remaining <= step;
+					s->remaining -= out ? s->remaining : step;
+				}
+				if (!out && s->timed) {
+					out = execution_limit::clock::now() >= s->deadline;
+				}
+				if (!out) {
+					return;
+				}
+				s->exceeded = true;
+#if SOL_LUA_VERSION >= 502
+#if SOL_LUA_VERSION >= 503
+				bool yieldable = lua_isyieldable(L) != 0;
+#else
+				bool yieldable = true;
+#endif // Lua 5.3 can tell whether the thread may yield
+				if (s->yields && s->L == L && yieldable) {
+					// count hooks may yield, and the coroutine picks up where it left off when resumed
+					lua_yield(L, 0);
+					return;
+				}
+#endif // Lua 5.1 cannot yield from hooks
+			}
+			// keep raising on every instruction until the limited call returns, so a pcall in the script cannot swallow the error
+			lua_sethook(L, &limit_hook, LUA_MASKCOUNT, 1);
+			luaL_error(L, "sol: execution limit exceeded");
+		}
+
+		// installs the hook for the duration of one call, and puts back whatever hook was there before
+		class limit_scope {
+		private:
+			limit_state state;
+			lua_Hook old_hook;
+			int old_mask;
+			int old_count;
+			bool active;
+
+		public:
+			limit_scope(lua_State* L, const execution_limit& limit, bool yields) : active(limit.active()) {
+				if (!active) {
+					return;
+				}
+				int step = limit.granularity < 1 ? 1 : limit.granularity;
+				if (limit.instructions != 0 && limit.instructions < static_cast<std::size_t>(step)) {
+					step = static_cast<int>(limit.instructions);
+				}
+				state.L = L;
+				state.main = limit_main_thread(L);
+				state.previous = current_limit();
+				state.remaining = limit.instructions;
+				state.step = step;
+				state.counted = limit.instructions != 0;
+				state.timed = limit.time != execution_limit::clock::duration::zero();
+				state.yields = yields;
+				state.exceeded = false;
+				if (state.timed) {
+					state.deadline = execution_limit::clock::now() + limit.time;
+				}
+				current_limit() = &state;
+				old_hook = lua_gethook(L);
+				old_mask = lua_gethookmask(L);
+				old_count = lua_gethookcount(L);
+				lua_sethook(L, &limit_hook, LUA_MASKCOUNT, step);
+			}
+
+			limit_scope(const limit_scope&) = delete;
+			limit_scope& operator=(const limit_scope&) = delete;
+
+			~limit_scope() {
+				if (!active) {
+					return;
+				}
+				lua_sethook(state.L, old_hook, old_mask, old_count);
+				current_limit() = state.previous;
+			}
+
+			bool exceeded() const {
+				return active && state.exceeded;
+			}
+		};
+	} // detail
+} // sol
+
+#endif // SOL_EXECUTION_LIMIT_HPP
@@ -28,6 +28,22 @@
 #endif // noexcept is part of a function's type
 #endif
 
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && defined(__has_include)
+#if __has_include(<coroutine>)
+#ifndef SOL_CXX20_COROUTINES
+#define SOL_CXX20_COROUTINES 1
+#endif // C++20 coroutines
+#endif // <coroutine> is available
+#endif
+
+#if defined(__has_include) && ((defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || __cplusplus >= 201703L)
+#if __has_include(<string_view>)
+#ifndef SOL_STD_STRING_VIEW
+#define SOL_STD_STRING_VIEW 1
+#endif // std::string_view
+#endif // <string_view> is available
+#endif
+
 #if defined(_WIN32) || defined(_MSC_VER)
 #ifndef SOL_CODECVT_SUPPORT
 #define SOL_CODECVT_SUPPORT 1
@@ -0,0 +1,288 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_FIELDS_HPP
+#define SOL_FIELDS_HPP
+
+#include "stack.hpp"
+#include <tuple>
+#include <utility>
+
+namespace sol {
+
+	template <typename... Tn>
+	struct field_list {
+		typedef std::make_index_sequence<sizeof...(Tn) / 2> indices;
+
+		std::tuple<Tn...> layout;
+
+		template <typename... Args>
+		field_list(Args&&... args) : layout(std::forward<Args>(args)...) {
+			static_assert(sizeof...(Tn) % 2 == 0, "sol::fields must be given as \"name\", &T::member pairs");
+		}
+
+		static constexpr std::size_t size() {
+			return sizeof...(Tn) / 2;
+		}
+	};
+
+	template <typename... Args>
+	field_list<std::decay_t<Args>...> fields(Args&&... args) {
+		return field_list<std::decay_t<Args>...>(std::forward<Args>(args)...);
+	}
+
+	template <typename T>
+	struct lazy_view {
+		const T* value;
+
+		lazy_view(const T& value) : value(&value) {}
+	};
+
+	template <typename T>
+	lazy_view<T> make_lazy_view(const T& value) {
+		return lazy_view<T>(value);
+	}
+
+	namespace detail {
+		inline int fail_on_lazy_view_newindex(lua_State* L) {
+			return luaL_error(L, "sol: cannot modify the fields of a lazy_view");
+		}
+
+		template <typename T>
+		struct struct_marshal {
+			typedef meta::unqualified_t<decltype(struct_fields<T>::get())> list_type;
+			typedef typename list_type::indices indices;
+
+			static const list_type& list() {
+				static const list_type l = struct_fields<T>::get();
+				return l;
+			}
+
+			static void* keys_tag() {
+				static char tag = 0;
+				return &tag;
+			}
+
+			template <std::size_t... I>
+			static void create_keys(lua_State* L, int keysindex, std::index_sequence<I...>) {
+				const list_type& l = list();
+				(void)l;
+				swallow{ 0, (stack::push(L, std::get<I * 2>(l.layout)), lua_rawseti(L, keysindex, static_cast<lua_Integer>(I + 1)), 0)... };
+			}
+
+			// the key strings are kept in the registry per state, so marshalling
+			// only does a raw array read per field instead of re-hashing each name
+			static int push_keys(lua_State* L) {
+				lua_pushlightuserdata(L, keys_tag());
+				lua_rawget(L, LUA_REGISTRYINDEX);
+				if (lua_isnil(L, -1)) {
+					lua_pop(L, 1);
+					lua_createtable(L, static_cast<int>(list_type::size()), 0);
+					create_keys(L, lua_gettop(L), indices());
+					lua_pushlightuserdata(L, keys_tag());
+					lua_pushvalue(L, -2);
+					lua_rawset(L, LUA_REGISTRYINDEX);
+				}
+				return lua_gettop(L);
+			}
+
+			template <std::size_t... I>
+			static void push_fields(lua_State* L, int tableindex, int keysindex, const T& value, std::index_sequence<I...>) {
+				const list_type& l = list();
+				(void)l;
+				swallow{ 0, (lua_rawgeti(L, keysindex, static_cast<lua_Integer>(I + 1)), stack::push(L, value.*std::get<I * 2 + 1>(l.layout)), lua_rawset(L, tableindex), 0)... };
+			}
+
+			template <typename M>
+			static void get_field(lua_State* L, int tableindex, int keysindex, lua_Integer i, M& member) {
+				lua_rawgeti(L, keysindex, i);
+				lua_rawget(L, tableindex);
+				if (!lua_isnil(L, -1)) {
+					member = stack::get<meta::unqualified_t<M>>(L, -1);
+				}
+				lua_pop(L, 1);
+			}
+
+			template <std::size_t... I>
+			static void get_fields(lua_State* L, int tableindex, int keysindex, T& value, std::index_sequence<I...>) {
+				const list_type& l = list();
+				(void)l;
+				swallow{ 0, (get_field(L, tableindex, keysindex, static_cast<lua_Integer>(I + 1), value.*std::get<I * 2 + 1>(l.layout)), 0)... };
+			}
+
+			template <typename M, typename Handler>
+			static bool check_field(std::false_type, lua_State*, int, int, lua_Integer, Handler&&) {
+				return true;
+			}
+
+			// nested struct fields are read with raw table access, so they must be tables (or absent)
+			template <typename M, typename Handler>
+			static bool check_field(std::true_type, lua_State* L, int tableindex, int keysindex, lua_Integer i, Handler&& handler) {
+				lua_rawgeti(L, keysindex, i);
+				lua_rawget(L, tableindex);
+				bool success = lua_isnil(L, -1) || stack::check<M>(L, lua_gettop(L), std::forward<Handler>(handler));
+				lua_pop(L, 1);
+				return success;
+			}
+
+			template <typename M, typename Handler>
+			static bool check_field(lua_State* L, int tableindex, int keysindex, lua_Integer i, M T::*, Handler&& handler) {
+				typedef meta::unqualified_t<M> member_type;
+				return check_field<member_type>(has_struct_fields<member_type>(), L, tableindex, keysindex, i, std::forward<Handler>(handler));
+			}
+
+			template <std::size_t... I, typename Handler>
+			static bool check_fields(lua_State* L, int tableindex, int keysindex, Handler&& handler, std::index_sequence<I...>) {
+				const list_type& l = list();
+				(void)l;
+				bool success = true;
+				swallow{ 0, (success = success && check_field(L, tableindex, keysindex, static_cast<lua_Integer>(I + 1), std::get<I * 2 + 1>(l.layout), handler), 0)... };
+				return success;
+			}
+
+			template <typename M>
+			static void push_member(std::true_type, lua_State* L, const M& member) {
+				stack::push(L, lazy_view<M>(member));
+			}
+
+			template <typename M>
+			static void push_member(std::false_type, lua_State* L, const M& member) {
+				stack::push(L, member);
+			}
+
+			template <std::size_t I>
+			static void push_field(lua_State* L, const T& value) {
+				const auto& member = value.*std::get<I * 2 + 1>(list().layout);
+				push_member(has_struct_fields<meta::unqualified_t<decltype(member)>>(), L, member);
+			}
+
+			typedef void(*field_pusher)(lua_State*, const T&);
+
+			template <std::size_t... I>
+			static const field_pusher* field_pushers(std::index_sequence<I...>) {
+				static const field_pusher pushers[] = { &push_field<I>... };
+				return pushers;
+			}
+
+			static int lazy_index(lua_State* L) {
+				// upvalue 1 maps each field name to its position in the field list
+				lua_pushvalue(L, 2);
+				lua_rawget(L, lua_upvalueindex(1));
+				if (lua_type(L, -1) != LUA_TNUMBER) {
+					lua_pushnil(L);
+					return 1;
+				}
+				std::size_t which = static_cast<std::size_t>(lua_tointeger(L, -1));
+				const T* value = *static_cast<const T**>(lua_touserdata(L, 1));
+				field_pushers(indices())[which](L, *value);
+				return 1;
+			}
+
+			template <std::size_t... I>
+			static void create_lazy_lookup(lua_State* L, int lookupindex, std::index_sequence<I...>) {
+				const list_type& l = list();
+				(void)l;
+				swallow{ 0, (stack::push(L, std::get<I * 2>(l.layout)), lua_pushinteger(L, static_cast<lua_Integer>(I)), lua_rawset(L, lookupindex), 0)... };
+			}
+
+			static void create_lazy_metatable(lua_State* L, int mtindex) {
+				lua_createtable(L, 0, static_cast<int>(list_type::size()));
+				create_lazy_lookup(L, lua_gettop(L), indices());
+				lua_pushcclosure(L, &lazy_index, 1);
+				lua_setfield(L, mtindex, "__index");
+				lua_pushcfunction(L, &fail_on_lazy_view_newindex);
+				lua_setfield(L, mtindex, "__newindex");
+			}
+		};
+	} // detail
+
+	namespace stack {
+		template <typename T>
+		struct pusher<T, std::enable_if_t<has_struct_fields<T>::value>> {
+			typedef detail::struct_marshal<T> marshal;
+
+			static int push(lua_State* L, const T& value) {
+				luaL_checkstack(L, 4, "not enough space left on Lua stack to push a struct's fields");
+				lua_createtable(L, 0, static_cast<int>(marshal::list_type::size()));
+				int tableindex = lua_gettop(L);
+				int keysindex = marshal::push_keys(L);
+				marshal::push_fields(L, tableindex, keysindex, value, typename marshal::indices());
+				lua_pop(L, 1);
+				return 1;
+			}
+		};
+
+		template <typename T>
+		struct pusher<lazy_view<T>> {
+			static int push(lua_State* L, const lazy_view<T>& view) {
+				const T** data = static_cast<const T**>(lua_newuserdata(L, sizeof(const T*)));
+				*data = view.value;
+				if (luaL_newmetatable(L, &usertype_traits<lazy_view<T>>::metatable()[0]) == 1) {
+					detail::struct_marshal<T>::create_lazy_metatable(L, lua_gettop(L));
+				}
+				lua_setmetatable(L, -2);
+				return 1;
+			}
+		};
+
+		template <typename T>
+		struct getter<T, std::enable_if_t<has_struct_fields<T>::value>> {
+			typedef detail::struct_marshal<T> marshal;
+
+			static T get(lua_State* L, int index, record& tracking) {
+				tracking.use(1);
+				int tableindex = lua_absindex(L, index);
+				T value{};
+				if (type_of(L, tableindex) != type::table) {
+					return value;
+				}
+				int keysindex = marshal::push_keys(L);
+				marshal::get_fields(L, tableindex, keysindex, value, typename marshal::indices());
+				lua_pop(L, 1);
+				return value;
+			}
+		};
+
+		template <typename T>
+		struct checker<T, type::table, std::enable_if_t<has_struct_fields<T>::value>> {
+			typedef detail::struct_marshal<T> marshal;
+
+			template <typename Handler>
+			static bool check(lua_State* L, int index, Handler&& handler, record& tracking) {
+				tracking.use(1);
+				type t = type_of(L, index);
+				if (t != type::table) {
+					handler(L, index, type::table, t);
+					return false;
+				}
+				luaL_checkstack(L, 3, "not enough space left on Lua stack to check a struct's fields");
+				int tableindex = lua_absindex(L, index);
+				int keysindex = marshal::push_keys(L);
+				bool success = marshal::check_fields(L, tableindex, keysindex, handler, typename marshal::indices());
+				lua_pop(L, 1);
+				return success;
+			}
+		};
+	} // stack
+} // sol
+
+#endif // SOL_FIELDS_HPP
@@ -0,0 +1,211 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_GLOBAL_WATCH_HPP
+#define SOL_GLOBAL_WATCH_HPP
+
+#include "table.hpp"
+#include "optional.hpp"
+#include <string>
+
+namespace sol {
+	namespace detail {
+		struct global_watch_slot {
+			std::size_t version;
+		};
+
+		inline const char* global_watch_key() {
+			return "sol.global_watch";
+		}
+
+		inline int global_watch_index(lua_State* L) {
+			// upvalues: 1 = watched values, 2 = slots, 3 = previous __index
+			lua_pushvalue(L, 2);
+			lua_rawget(L, lua_upvalueindex(2));
+			bool watched = !lua_isnil(L, -1);
+			lua_pop(L, 1);
+			if (watched) {
+				lua_pushvalue(L, 2);
+				lua_rawget(L, lua_upvalueindex(1));
+				return 1;
+			}
+			int previous = lua_upvalueindex(3);
+			switch (lua_type(L, previous)) {
+			case LUA_TNIL:
+				lua_pushnil(L);
+				break;
+			case LUA_TFUNCTION:
+				lua_pushvalue(L, previous);
+				lua_pushvalue(L, 1);
+				lua_pushvalue(L, 2);
+				lua_call(L, 2, 1);
+				break;
+			default:
+				lua_pushvalue(L, 2);
+				lua_gettable(L, previous);
+				break;
+			}
+			return 1;
+		}
+
+		inline int global_watch_newindex(lua_State* L) {
+			// upvalues: 1 = watched values, 2 = slots, 3 = previous __newindex
+			lua_pushvalue(L, 2);
+			lua_rawget(L, lua_upvalueindex(2));
+			if (!lua_isnil(L, -1)) {
+				global_watch_slot* slot = static_cast<global_watch_slot*>(lua_touserdata(L, -1));
+				++slot->version;
+				lua_pushvalue(L, 2);
+				lua_pushvalue(L, 3);
+				lua_rawset(L, lua_upvalueindex(1));
+				return 0;
+			}
+			lua_pop(L, 1);
+			int previous = lua_upvalueindex(3);
+			switch (lua_type(L, previous)) {
+			case LUA_TNIL:
+				lua_rawset(L, 1);
+				break;
+			case LUA_TFUNCTION:
+				lua_pushvalue(L, previous);
+				lua_insert(L, 1);
+				lua_call(L, 3, 0);
+				break;
+			default:
+				lua_settable(L, previous);
+				break;
+			}
+			return 0;
+		}
+
+		inline void install_global_watch_metamethod(lua_State* L, int mtindex, int valuesindex, const char* name, lua_CFunction f) {
+			lua_pushvalue(L, valuesindex);
+			lua_pushvalue(L, valuesindex + 1);
+			lua_getfield(L, mtindex, name);
+			lua_pushcclosure(L, f, 3);
+			lua_setfield(L, mtindex, name);
+		}
+
+		// pushes the watch table ({ [1] = watched values, [2] = slots }),
+		// hooking the globals table the first time it is needed
+		inline void push_global_watch(lua_State* L) {
+			lua_getfield(L, LUA_REGISTRYINDEX, global_watch_key());
+			if (!lua_isnil(L, -1)) {
+				return;
+			}
+			lua_pop(L, 1);
+			lua_createtable(L, 2, 0);
+			int watchindex = lua_gettop(L);
+			lua_newtable(L);
+			lua_newtable(L);
+			lua_pushglobaltable(L);
+			int globalsindex = lua_gettop(L);
+			if (lua_getmetatable(L, globalsindex) == 0) {
+				lua_newtable(L);
+				lua_pushvalue(L, -1);
+				lua_setmetatable(L, globalsindex);
+			}
+			int mtindex = lua_gettop(L);
+			install_global_watch_metamethod(L, mtindex, watchindex + 1, "__index", &global_watch_index);
+			install_global_watch_metamethod(L, mtindex, watchindex + 1, "__newindex", &global_watch_newindex);
+			lua_settop(L, watchindex + 2);
+			lua_rawseti(L, watchindex, 2);
+			lua_rawseti(L, watchindex, 1);
+			lua_pushvalue(L, watchindex);
+			lua_setfield(L, LUA_REGISTRYINDEX, global_watch_key());
+		}
+
+		inline global_watch_slot* watch_global_slot(lua_State* L, const std::string& name, table& values) {
+			push_global_watch(L);
+			int watchindex = lua_gettop(L);
+			lua_rawgeti(L, watchindex, 1);
+			values = table(L, -1);
+			lua_rawgeti(L, watchindex, 2);
+			int slotsindex = lua_gettop(L);
+			stack::push(L, name);
+			lua_rawget(L, slotsindex);
+			if (lua_isnil(L, -1)) {
+				lua_pop(L, 1);
+				void* memory = lua_newuserdata(L, sizeof(global_watch_slot));
+				// starts at 1, so a fresh handle always reads once
+				new (memory) global_watch_slot{ 1 };
+				stack::push(L, name);
+				lua_pushvalue(L, -2);
+				lua_rawset(L, slotsindex);
+				// move the current value out of the globals table, so every assignment goes through __newindex
+				lua_pushglobaltable(L);
+				int globalsindex = lua_gettop(L);
+				stack::push(L, name);
+				lua_pushvalue(L, -1);
+				lua_rawget(L, globalsindex);
+				lua_rawset(L, watchindex + 1);
+				stack::push(L, name);
+				lua_pushnil(L);
+				lua_rawset(L, globalsindex);
+				lua_pop(L, 1);
+			}
+			global_watch_slot* slot = static_cast<global_watch_slot*>(lua_touserdata(L, -1));
+			lua_settop(L, watchindex - 1);
+			return slot;
+		}
+	} // detail
+
+	template <typename T>
+	class global_watch {
+	private:
+		std::string name;
+		table values;
+		detail::global_watch_slot* slot;
+		std::size_t seen;
+		optional<T> value;
+
+	public:
+		global_watch(lua_State* L, std::string key) : name(std::move(key)), values(), slot(nullptr), seen(0) {
+			slot = detail::watch_global_slot(L, name, values);
+		}
+
+		const T& get() {
+			if (seen != slot->version) {
+				lua_State* L = values.lua_state();
+				auto pp = stack::push_pop(values);
+				stack::get_field<false, true>(L, name, lua_gettop(L));
+				value = stack::pop<T>(L);
+				seen = slot->version;
+			}
+			return *value;
+		}
+
+		const T& operator*() {
+			return get();
+		}
+
+		bool stale() const {
+			return seen != slot->version;
+		}
+
+		const std::string& key() const {
+			return name;
+		}
+	};
+} // sol
+
+#endif // SOL_GLOBAL_WATCH_HPP
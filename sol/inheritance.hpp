@@ -67,13 +67,14 @@ namespace sol {
 			return key;
 		}
 
+		// the escapes already spell UTF-8, and a u8 literal would be char8_t in C++20
 		inline decltype(auto) base_class_index_propogation_key() {
-			static const auto& key = u8"\xF0\x9F\x8C\xB2.index";
+			static const auto& key = "\xF0\x9F\x8C\xB2.index";
 			return key;
 		}
 
 		inline decltype(auto) base_class_new_index_propogation_key() {
-			static const auto& key = u8"\xF0\x9F\x8C\xB2.new_index";
+			static const auto& key = "\xF0\x9F\x8C\xB2.new_index";
 			return key;
 		}
 
@@ -0,0 +1,65 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_INTERNED_KEY_HPP
+#define SOL_INTERNED_KEY_HPP
+
+#include "reference.hpp"
+#include "stack.hpp"
+#include <string>
+
+namespace sol {
+
+	// A string key kept alive in the registry: pushing it is a single lua_rawgeti
+	// on the registry instead of hashing and interning the string again every time
+	class interned_key : public reference {
+	private:
+		typedef reference base_t;
+
+		static int push_string(lua_State* L, const char* name, std::size_t len) {
+			lua_pushlstring(L, name, len);
+			return -1;
+		}
+
+	public:
+		interned_key() noexcept = default;
+		interned_key(lua_State* L, const char* name) : interned_key(L, name, std::char_traits<char>::length(name)) {}
+		interned_key(lua_State* L, const std::string& name) : interned_key(L, name.data(), name.size()) {}
+		interned_key(lua_State* L, const char* name, std::size_t len) : base_t(L, push_string(L, name, len)) {
+			lua_pop(L, 1);
+		}
+		interned_key(const interned_key&) = default;
+		interned_key(interned_key&&) = default;
+		interned_key& operator=(const interned_key&) = default;
+		interned_key& operator=(interned_key&&) = default;
+
+		std::string str() const {
+			auto pp = stack::push_pop(*this);
+			std::size_t len = 0;
+			const char* s = lua_tolstring(lua_state(), -1, &len);
+			return std::string(s, len);
+		}
+	};
+
+} // sol
+
+#endif // SOL_INTERNED_KEY_HPP
@@ -0,0 +1,115 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_KEY_PATH_HPP
+#define SOL_KEY_PATH_HPP
+
+#include "table.hpp"
+
+namespace sol {
+
+	class key_path {
+	private:
+		reference keys;
+		int count = 0;
+
+		void push_resolved(lua_State* L) const {
+			// the root is on top of the stack: walk the keys kept in our table,
+			// replacing the current value with the next one
+			int current = lua_gettop(L);
+			keys.push(L);
+			int keysidx = lua_gettop(L);
+			for (int i = 1; i <= count; ++i) {
+				type t = type_of(L, current);
+				if (t != type::table && t != type::userdata) {
+					lua_pushnil(L);
+					lua_replace(L, current);
+					break;
+				}
+				lua_rawgeti(L, keysidx, i);
+				if (t == type::table) {
+					lua_rawget(L, current);
+				}
+				else {
+					lua_gettable(L, current);
+				}
+				lua_replace(L, current);
+			}
+			lua_settop(L, current);
+		}
+
+	public:
+		key_path() = default;
+
+		template <typename Key, typename... Keys>
+		key_path(lua_State* L, Key&& key, Keys&&... rest) : count(static_cast<int>(1 + sizeof...(Keys))) {
+			lua_createtable(L, count, 0);
+			int i = 0;
+			(void)detail::swallow{ 0, (stack::push(L, std::forward<Key>(key)), lua_rawseti(L, -2, ++i), 0), (stack::push(L, std::forward<Keys>(rest)), lua_rawseti(L, -2, ++i), 0)... };
+			keys = reference(L, -1);
+			lua_pop(L, 1);
+		}
+
+		std::size_t size() const {
+			return static_cast<std::size_t>(count);
+		}
+
+		bool valid() const {
+			return keys.valid();
+		}
+
+		lua_State* lua_state() const {
+			return keys.lua_state();
+		}
+
+		template <typename Table, meta::disable<std::is_convertible<const Table&, lua_State*>> = meta::enabler>
+		int push(const Table& root) const {
+			lua_State* L = root.lua_state();
+			root.push();
+			push_resolved(L);
+			return 1;
+		}
+
+		int push(lua_State* L) const {
+			lua_pushglobaltable(L);
+			push_resolved(L);
+			return 1;
+		}
+
+		template <typename T, typename Table, meta::disable<std::is_convertible<const Table&, lua_State*>> = meta::enabler>
+		decltype(auto) get(const Table& root) const {
+			push(root);
+			detail::clean<1> c(root.lua_state());
+			return stack::get<T>(root.lua_state());
+		}
+
+		template <typename T>
+		decltype(auto) get(lua_State* L) const {
+			push(L);
+			detail::clean<1> c(L);
+			return stack::get<T>(L);
+		}
+	};
+
+} // sol
+
+#endif // SOL_KEY_PATH_HPP
@@ -0,0 +1,174 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_OBSERVABLE_TABLE_HPP
+#define SOL_OBSERVABLE_TABLE_HPP
+
+#include "table.hpp"
+#include "object.hpp"
+
+namespace sol {
+	namespace detail {
+		struct observable_counter {
+			std::size_t count;
+		};
+
+		inline int observable_newindex(lua_State* L) {
+			// upvalues: 1 = backing table, 2 = dirty set, 3 = counter
+			lua_pushvalue(L, 2);
+			lua_pushvalue(L, 3);
+			lua_rawset(L, lua_upvalueindex(1));
+			lua_pushvalue(L, 2);
+			lua_rawget(L, lua_upvalueindex(2));
+			if (lua_isnil(L, -1)) {
+				lua_pushvalue(L, 2);
+				lua_pushboolean(L, 1);
+				lua_rawset(L, lua_upvalueindex(2));
+				++static_cast<observable_counter*>(lua_touserdata(L, lua_upvalueindex(3)))->count;
+			}
+			return 0;
+		}
+
+		inline int observable_len(lua_State* L) {
+			lua_pushinteger(L, static_cast<lua_Integer>(lua_rawlen(L, lua_upvalueindex(1))));
+			return 1;
+		}
+
+		inline int observable_next(lua_State* L) {
+			lua_settop(L, 2);
+			if (lua_next(L, 1) == 0) {
+				lua_pushnil(L);
+				return 1;
+			}
+			return 2;
+		}
+
+		inline int observable_pairs(lua_State* L) {
+			lua_pushcfunction(L, &observable_next);
+			lua_pushvalue(L, lua_upvalueindex(1));
+			lua_pushnil(L);
+			return 3;
+		}
+
+		// leaves the dirty set, the counter and the proxy table on the stack, in that order
+		inline int push_observable_proxy(lua_State* L, const table& backing) {
+			lua_newtable(L);
+			int dirtyindex = lua_gettop(L);
+			void* memory = lua_newuserdata(L, sizeof(observable_counter));
+			new (memory) observable_counter{ 0 };
+			lua_newtable(L);
+			lua_createtable(L, 0, 4);
+			int mtindex = lua_gettop(L);
+			backing.push(L);
+			lua_setfield(L, mtindex, "__index");
+			backing.push(L);
+			lua_pushvalue(L, dirtyindex);
+			lua_pushvalue(L, dirtyindex + 1);
+			lua_pushcclosure(L, &observable_newindex, 3);
+			lua_setfield(L, mtindex, "__newindex");
+			backing.push(L);
+			lua_pushcclosure(L, &observable_len, 1);
+			lua_setfield(L, mtindex, "__len");
+			backing.push(L);
+			lua_pushcclosure(L, &observable_pairs, 1);
+			lua_setfield(L, mtindex, "__pairs");
+			lua_setmetatable(L, -2);
+			return -1;
+		}
+	} // detail
+
+	// The dirty set is a Lua table rather than a C++ container: keys can be any Lua value (tables, userdata, functions),
+	// and holding them from C++ would take a registry reference per key. Only the count lives in C++, so dirty() is free
+	class observable_table : public table {
+	private:
+		table store;
+		table dirtyset;
+		detail::observable_counter* counter;
+
+	public:
+		observable_table(lua_State* L, const table& backing) : table(L, detail::push_observable_proxy(L, backing)), store(backing), dirtyset(L, -3), counter(static_cast<detail::observable_counter*>(lua_touserdata(L, -2))) {
+			lua_pop(L, 3);
+		}
+
+		observable_table(lua_State* L, int narr = 0, int nrec = 0) : observable_table(L, table::create(L, narr, nrec)) {
+		}
+
+		table& backing() {
+			return store;
+		}
+
+		const table& backing() const {
+			return store;
+		}
+
+		std::size_t dirty_count() const {
+			return counter->count;
+		}
+
+		bool dirty() const {
+			return dirty_count() != 0;
+		}
+
+		template <typename K = object, typename V = object, typename Fx>
+		void for_each_dirty(Fx&& fx) const {
+			lua_State* L = lua_state();
+			auto ppd = stack::push_pop(dirtyset);
+			int dirtyindex = lua_gettop(L);
+			auto pps = stack::push_pop(store);
+			int storeindex = lua_gettop(L);
+			stack::push(L, lua_nil);
+			while (lua_next(L, dirtyindex)) {
+				lua_pop(L, 1);
+				int keyindex = lua_gettop(L);
+				lua_pushvalue(L, keyindex);
+				lua_rawget(L, storeindex);
+				// convert a copy of the key, so string conversions cannot confuse lua_next
+				lua_pushvalue(L, keyindex);
+				fx(stack::get<K>(L, keyindex + 2), stack::get<V>(L, keyindex + 1));
+				lua_settop(L, keyindex);
+			}
+		}
+
+		void clear_dirty() {
+			lua_State* L = lua_state();
+			auto pp = stack::push_pop(dirtyset);
+			int dirtyindex = lua_gettop(L);
+			stack::push(L, lua_nil);
+			while (lua_next(L, dirtyindex)) {
+				// clearing fields that already exist is allowed during traversal
+				lua_pop(L, 1);
+				lua_pushvalue(L, -1);
+				lua_pushnil(L);
+				lua_rawset(L, dirtyindex);
+			}
+			counter->count = 0;
+		}
+
+		template <typename K = object, typename V = object, typename Fx>
+		void sync(Fx&& fx) {
+			for_each_dirty<K, V>(std::forward<Fx>(fx));
+			clear_dirty();
+		}
+	};
+} // sol
+
+#endif // SOL_OBSERVABLE_TABLE_HPP
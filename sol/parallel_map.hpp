@@ -0,0 +1,183 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_PARALLEL_MAP_HPP
+#define SOL_PARALLEL_MAP_HPP
+
+#include "state_pool.hpp"
+#include "serialize.hpp"
+#include <vector>
+#include <string>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+
+namespace sol {
+	namespace detail {
+		// a Lua function as bytecode, plus its upvalues encoded by value
+		struct packed_function {
+			struct upvalue {
+				bool environment;
+				std::string value;
+			};
+
+			std::string bytecode;
+			std::vector<upvalue> upvalues;
+		};
+
+		inline void parallel_map_fail(const char* message) {
+#ifndef SOL_NO_EXCEPTIONS
+			throw error(message);
+#else
+			(void)message;
+#endif // No Exceptions
+		}
+
+		inline packed_function pack_function(const object& func) {
+			packed_function packed;
+			lua_State* L = func.lua_state();
+			settop_on_exit restore{ L, lua_gettop(L) };
+			func.push();
+			if (lua_type(L, -1) != LUA_TFUNCTION || lua_iscfunction(L, -1)) {
+				parallel_map_fail("sol: parallel_map needs a Lua function");
+				return packed;
+			}
+			int index = lua_gettop(L);
+			// not stripped, so the upvalues keep their names and _ENV can be told apart
+			packed.bytecode = dump_function(L);
+			for (int i = 1; ; ++i) {
+				const char* name = lua_getupvalue(L, index, i);
+				if (name == nullptr) {
+					break;
+				}
+				packed_function::upvalue up{ std::strcmp(name, "_ENV") == 0, std::string() };
+				if (!up.environment && binary_writer(L, up.value).write(-1) != nullptr) {
+					parallel_map_fail("sol: parallel_map can only copy upvalues that can be serialized");
+					return packed;
+				}
+				lua_pop(L, 1);
+				packed.upvalues.push_back(std::move(up));
+			}
+			return packed;
+		}
+
+		// leaves the function on top of the worker's stack, or nothing if it could not be rebuilt
+		inline bool unpack_function(lua_State* L, const packed_function& packed) {
+			if (luaL_loadbuffer(L, packed.bytecode.data(), packed.bytecode.size(), "=parallel_map") != LUA_OK) {
+				std::string message = lua_type(L, -1) == LUA_TSTRING ? lua_tostring(L, -1) : "sol: parallel_map could not load the function";
+				lua_pop(L, 1);
+#ifndef SOL_NO_EXCEPTIONS
+				throw error(message);
+#else
+				return false;
+#endif // No Exceptions
+			}
+			int index = lua_gettop(L);
+			for (std::size_t i = 0; i < packed.upvalues.size(); ++i) {
+				const packed_function::upvalue& up = packed.upvalues[i];
+				if (up.environment) {
+					lua_pushglobaltable(L);
+				}
+				else if (binary_decode(L, up.value.data(), up.value.size()) != nullptr) {
+					// e.g. a usertype whose serializer is registered in the calling state but not in the worker's
+					lua_settop(L, index - 1);
+					parallel_map_fail("sol: parallel_map could not rebuild an upvalue in a worker state");
+					return false;
+				}
+				lua_setupvalue(L, index, static_cast<int>(i + 1));
+			}
+			return true;
+		}
+	} // detail
+
+	template <typename R, typename Range>
+	std::vector<R> parallel_map(state_pool& pool, const object& func, const Range& inputs, std::size_t chunk_size = 0) {
+		static_assert(!is_lua_reference<R>::value, "results of parallel_map must be plain C++ values: Lua references cannot leave the worker's state");
+		typedef decltype(std::begin(inputs)) iterator;
+		static_assert(std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<iterator>::iterator_category>::value, "parallel_map needs a range with random access iterators");
+		static_assert(!is_lua_reference<std::decay_t<decltype(*std::begin(inputs))>>::value, "inputs of parallel_map must be plain C++ values: Lua references belong to the calling state and cannot be pushed into a worker");
+		detail::packed_function packed = detail::pack_function(func);
+		iterator first = std::begin(inputs);
+		std::size_t count = static_cast<std::size_t>(std::distance(first, std::end(inputs)));
+		std::vector<R> results;
+		if (count == 0) {
+			return results;
+		}
+		if (chunk_size == 0) {
+			// a few chunks per worker, so that a slow chunk does not hold everything up
+			chunk_size = std::max<std::size_t>(1, count / (pool.size() * 4));
+		}
+		// each chunk fills its own vector, which also keeps std::vector<bool> results free of races
+		std::vector<std::future<std::vector<R>>> chunks;
+		chunks.reserve(count / chunk_size + 1);
+		for (std::size_t begin = 0; begin < count; begin += chunk_size) {
+			std::size_t end = std::min(count, begin + chunk_size);
+			chunks.push_back(pool.submit_with([&packed, first, begin, end](state& lua) {
+				std::vector<R> part;
+				part.reserve(end - begin);
+				lua_State* L = lua.lua_state();
+				int base = lua_gettop(L);
+				detail::settop_on_exit restore{ L, base };
+				lua_pushcfunction(L, &default_error_handler);
+				if (!detail::unpack_function(L, packed)) {
+					return part;
+				}
+				int fx = lua_gettop(L);
+				for (std::size_t i = begin; i < end; ++i) {
+					lua_pushvalue(L, fx);
+					stack::push(L, *(first + i));
+					if (lua_pcall(L, 1, 1, base + 1) != LUA_OK) {
+						std::string message = lua_type(L, -1) == LUA_TSTRING ? lua_tostring(L, -1) : "sol: parallel_map function failed";
+#ifndef SOL_NO_EXCEPTIONS
+						throw error(message);
+#else
+						return part;
+#endif // No Exceptions
+					}
+					part.push_back(stack::pop<R>(L));
+				}
+				return part;
+			}));
+		}
+		// every chunk refers to this frame, so all of them have to be done before any error leaves it
+		for (std::future<std::vector<R>>& chunk : chunks) {
+			chunk.wait();
+		}
+		results.reserve(count);
+		for (std::future<std::vector<R>>& chunk : chunks) {
+			std::vector<R> part = chunk.get();
+			std::move(part.begin(), part.end(), std::back_inserter(results));
+		}
+		return results;
+	}
+
+	template <typename R, typename Range>
+	std::vector<R> parallel_map(const object& func, const Range& inputs, std::size_t threads = 0) {
+		if (threads == 0) {
+			threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+		}
+		state_pool pool(threads, [](state& lua) { lua.open_libraries(); });
+		return parallel_map<R>(pool, func, inputs);
+	}
+} // sol
+
+#endif // SOL_PARALLEL_MAP_HPP
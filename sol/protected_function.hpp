@@ -25,6 +25,7 @@
 #include "reference.hpp"
 #include "stack.hpp"
 #include "protected_function_result.hpp"
+#include "execution_limit.hpp"
 #include <cstdint>
 #include <algorithm>
 
@@ -70,7 +71,12 @@ namespace sol {
 
 	private:
 		call_status luacall(std::ptrdiff_t argcount, std::ptrdiff_t resultcount, detail::handler& h) const {
-			return static_cast<call_status>(lua_pcallk(base_t::lua_state(), static_cast<int>(argcount), static_cast<int>(resultcount), h.stackindex, 0, nullptr));
+			detail::limit_scope ls(base_t::lua_state(), limit, false);
+			call_status code = static_cast<call_status>(lua_pcallk(base_t::lua_state(), static_cast<int>(argcount), static_cast<int>(resultcount), h.stackindex, 0, nullptr));
+			if (code == call_status::runtime && ls.exceeded()) {
+				return call_status::timeout;
+			}
+			return code;
 		}
 
 		template<std::size_t... I, typename... Ret>
@@ -138,6 +144,7 @@ namespace sol {
 
 	public:
 		reference error_handler;
+		execution_limit limit;
 
 		basic_protected_function() = default;
 		template <typename T, meta::enable<meta::neg<std::is_same<meta::unqualified_t<T>, basic_protected_function>>, meta::neg<std::is_same<base_t, stack_reference>>, std::is_base_of<base_t, meta::unqualified_t<T>>> = meta::enabler>
@@ -31,7 +31,7 @@ namespace sol {
 			template<typename T, typename... Args>
 			static void construct(T&& obj, Args&&... args) {
 				std::allocator<meta::unqualified_t<T>> alloc{};
-				alloc.construct(obj, std::forward<Args>(args)...);
+				std::allocator_traits<std::allocator<meta::unqualified_t<T>>>::construct(alloc, obj, std::forward<Args>(args)...);
 			}
 
 			template<typename T, typename... Args>
@@ -44,7 +44,7 @@ namespace sol {
 			template<typename T>
 			static void destroy(T&& obj) {
 				std::allocator<meta::unqualified_t<T>> alloc{};
-				alloc.destroy(obj);
+				std::allocator_traits<std::allocator<meta::unqualified_t<T>>>::destroy(alloc, obj);
 			}
 
 			template<typename T>
@@ -0,0 +1,84 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_REFERENCE_ARENA_HPP
+#define SOL_REFERENCE_ARENA_HPP
+
+#include "stack.hpp"
+#include "object.hpp"
+
+namespace sol {
+	class reference_arena {
+	private:
+		lua_State* L;
+		int base;
+
+		template <typename T>
+		T adopt_top() {
+			static_assert(std::is_base_of<stack_reference, T>::value, "arena objects must be stack-based (e.g., sol::stack_object, sol::stack_table), since they live in the arena's stack slots");
+			return T(L, lua_gettop(L));
+		}
+
+	public:
+		reference_arena(lua_State* L, int reserve = 0) : L(L), base(lua_gettop(L)) {
+			if (reserve > 0) {
+				luaL_checkstack(L, reserve, "not enough space left on Lua stack to reserve a reference arena");
+			}
+		}
+
+		reference_arena(const reference_arena&) = delete;
+		reference_arena& operator=(const reference_arena&) = delete;
+
+		~reference_arena() {
+			lua_settop(L, base);
+		}
+
+		template <typename T = stack_object, typename Arg>
+		T make(Arg&& arg) {
+			stack::push(L, std::forward<Arg>(arg));
+			return adopt_top<T>();
+		}
+
+		template <typename T = stack_object, typename Table, typename Key>
+		T get(const Table& t, Key&& key) {
+			t.push(L);
+			int tableindex = lua_gettop(L);
+			stack::get_field<false>(L, std::forward<Key>(key), tableindex);
+			lua_remove(L, -2);
+			return adopt_top<T>();
+		}
+
+		void clear() {
+			lua_settop(L, base);
+		}
+
+		int size() const {
+			return lua_gettop(L) - base;
+		}
+
+		lua_State* lua_state() const {
+			return L;
+		}
+	};
+} // sol
+
+#endif // SOL_REFERENCE_ARENA_HPP
@@ -0,0 +1,582 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_SCHEDULER_HPP
+#define SOL_SCHEDULER_HPP
+
+#include "thread_pool.hpp"
+#include "execution_limit.hpp"
+#include "yielding.hpp"
+#include "error.hpp"
+#include "object.hpp"
+#include <deque>
+#include <vector>
+#include <queue>
+#include <unordered_map>
+#include <string>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <memory>
+#include <cstdint>
+
+namespace sol {
+	typedef std::uint64_t task_id;
+
+	struct task_result {
+		call_status status = call_status::ok;
+		bool cancelled = false;
+		bool unknown = false;
+		std::vector<object> values;
+
+		bool valid() const {
+			return !cancelled && !unknown && status == call_status::ok;
+		}
+	};
+
+	namespace detail {
+		inline void scheduler_fail(task_id, const std::string& message) {
+#ifndef SOL_NO_EXCEPTIONS
+			throw error(message);
+#else
+			(void)message;
+#endif // No Exceptions
+		}
+	} // detail
+
+	class scheduler {
+	public:
+		typedef std::chrono::steady_clock clock;
+		typedef std::function<void(const task_result&)> finish_handler;
+
+	private:
+		enum class wait_kind {
+			next_tick,
+			sleep,
+			signal
+		};
+
+		struct task_ref {
+			std::uint32_t slot;
+			std::uint32_t generation;
+		};
+
+		struct task_entry {
+			thread runner;
+			lua_State* co = nullptr;
+			std::uint32_t generation = 0;
+			int nargs = 0;
+			bool alive = false;
+			bool signalled = false;
+			std::string signal;
+			std::unique_ptr<detail::pending_await> awaited;
+			std::vector<finish_handler> finishers;
+		};
+
+		struct sleeper {
+			double wake;
+			std::uint64_t order;
+			task_ref task;
+
+			bool operator>(const sleeper& right) const {
+				return wake > right.wake || (wake == right.wake && order > right.order);
+			}
+		};
+
+		lua_State* L;
+		std::string library;
+		scheduler** handle = nullptr;
+		reference handle_ref;
+		thread_pool pool;
+		std::vector<task_entry> tasks;
+		std::vector<std::uint32_t> free_slots;
+		std::deque<task_ref> ready;
+		std::priority_queue<sleeper, std::vector<sleeper>, std::greater<sleeper>> sleeping;
+		std::unordered_map<std::string, std::vector<task_ref>> waiting;
+		std::vector<task_ref> awaiting;
+		std::size_t live = 0;
+		std::uint64_t sleep_order = 0;
+		double current_time = 0;
+		std::size_t max_resumes = 0;
+		clock::duration max_time = clock::duration::zero();
+		execution_limit limit;
+		lua_State* current = nullptr;
+		wait_kind pending = wait_kind::next_tick;
+		double pending_wake = 0;
+		std::string pending_signal;
+		std::function<void(task_id, const std::string&)> on_error = detail::scheduler_fail;
+
+		static task_id to_id(task_ref t) {
+			return (static_cast<task_id>(t.generation) << 32) | t.slot;
+		}
+
+		static task_ref to_ref(task_id id) {
+			return task_ref{ static_cast<std::uint32_t>(id & 0xFFFFFFFFu), static_cast<std::uint32_t>(id >> 32) };
+		}
+
+		task_entry* lookup(task_ref t) {
+			if (t.slot >= tasks.size()) {
+				return nullptr;
+			}
+			task_entry& entry = tasks[t.slot];
+			if (!entry.alive || entry.generation != t.generation) {
+				return nullptr;
+			}
+			return &entry;
+		}
+
+		task_ref allocate(thread runner) {
+			std::uint32_t slot;
+			if (free_slots.empty()) {
+				slot = static_cast<std::uint32_t>(tasks.size());
+				tasks.emplace_back();
+			}
+			else {
+				slot = free_slots.back();
+				free_slots.pop_back();
+			}
+			task_entry& entry = tasks[slot];
+			entry.co = runner.thread_state();
+			entry.runner = std::move(runner);
+			entry.nargs = 0;
+			entry.alive = true;
+			++live;
+			return task_ref{ slot, entry.generation };
+		}
+
+		void stop_waiting(task_ref t, task_entry& entry) {
+			// a cancelled task would otherwise stay queued on a signal that may never fire
+			auto it = waiting.find(entry.signal);
+			if (it != waiting.end()) {
+				std::vector<task_ref>& queued = it->second;
+				queued.erase(std::remove_if(queued.begin(), queued.end(), [t](task_ref w) {
+					return w.slot == t.slot && w.generation == t.generation;
+				}), queued.end());
+				if (queued.empty()) {
+					waiting.erase(it);
+				}
+			}
+			entry.signalled = false;
+			entry.signal.clear();
+		}
+
+		void finish(task_ref t) {
+			task_entry& entry = tasks[t.slot];
+			if (entry.signalled) {
+				stop_waiting(t, entry);
+			}
+			pool.release(entry.runner);
+			entry.runner = thread();
+			entry.co = nullptr;
+			entry.awaited.reset();
+			entry.alive = false;
+			++entry.generation;
+			free_slots.push_back(t.slot);
+			--live;
+		}
+
+		void complete(task_ref t, const task_result& result) {
+			std::vector<finish_handler> done = std::move(tasks[t.slot].finishers);
+			tasks[t.slot].finishers.clear();
+			finish(t);
+			for (finish_handler& f : done) {
+				f(result);
+			}
+		}
+
+		void fail(task_ref t, const std::string& message) {
+			if (tasks[t.slot].finishers.empty()) {
+				finish(t);
+				on_error(to_id(t), message);
+				return;
+			}
+			task_result result;
+			result.status = call_status::runtime;
+			result.values.push_back(make_object(L, message));
+			complete(t, result);
+		}
+
+		void succeed(task_ref t) {
+			if (tasks[t.slot].finishers.empty()) {
+				finish(t);
+				return;
+			}
+			// the results are moved off the task's thread before it goes back to the pool
+			lua_State* co = tasks[t.slot].co;
+			int count = lua_gettop(co);
+			luaL_checkstack(L, count, "not enough space to collect the results of a task");
+			int base = lua_gettop(L);
+			lua_xmove(co, L, count);
+			task_result result;
+			result.values.reserve(count);
+			for (int i = 1; i <= count; ++i) {
+				result.values.emplace_back(L, base + i);
+			}
+			lua_settop(L, base);
+			complete(t, result);
+		}
+
+		int resume(lua_State* co, int nargs) {
+#if SOL_LUA_VERSION >= 504
+			int nresults = 0;
+			return lua_resume(co, L, nargs, &nresults);
+#elif SOL_LUA_VERSION >= 502
+			return lua_resume(co, L, nargs);
+#else
+			return lua_resume(co, nargs);
+#endif // Lua 5.4 returns the result count separately, 5.1 has no "from" thread
+		}
+
+		void run(task_ref t) {
+			task_entry& entry = tasks[t.slot];
+			lua_State* co = entry.co;
+			int nargs = entry.nargs;
+			entry.nargs = 0;
+			if (entry.awaited) {
+				std::unique_ptr<detail::pending_await> awaited = std::move(entry.awaited);
+#ifndef SOL_NO_EXCEPTIONS
+				try {
+					nargs = awaited->push(co);
+				}
+				catch (const std::exception& e) {
+					fail(t, e.what());
+					return;
+				}
+				catch (...) {
+					fail(t, "sol: awaited operation failed with an unknown error");
+					return;
+				}
+#else
+				nargs = awaited->push(co);
+#endif // No Exceptions
+			}
+			current = co;
+			pending = wait_kind::next_tick;
+			int status;
+			{
+				// a task that runs out of budget yields, and simply goes back to the ready queue
+				detail::limit_scope ls(co, limit, true);
+				status = resume(co, nargs);
+			}
+			current = nullptr;
+			if (status == LUA_YIELD) {
+				if (pending == wait_kind::next_tick && lua_gettop(co) > 0 && detail::is_pending_await(co, -1)) {
+					// spawning from inside the task may have grown the task list, so look the entry up again
+					std::unique_ptr<detail::pending_await> awaited = detail::take_pending_await(co, -1);
+					lua_settop(co, 0);
+					if (awaited) {
+						tasks[t.slot].awaited = std::move(awaited);
+						awaiting.push_back(t);
+						return;
+					}
+				}
+				lua_settop(co, 0);
+				switch (pending) {
+				case wait_kind::sleep:
+					sleeping.push(sleeper{ pending_wake, sleep_order++, t });
+					break;
+				case wait_kind::signal:
+					waiting[pending_signal].push_back(t);
+					tasks[t.slot].signalled = true;
+					tasks[t.slot].signal = pending_signal;
+					break;
+				case wait_kind::next_tick:
+				default:
+					ready.push_back(t);
+					break;
+				}
+				return;
+			}
+			if (status == LUA_OK) {
+				succeed(t);
+				return;
+			}
+			std::string message = lua_type(co, -1) == LUA_TSTRING ? lua_tostring(co, -1) : "sol: scheduled task failed with a non-string error";
+			fail(t, message);
+		}
+
+		void wake_sleepers() {
+			while (!sleeping.empty() && sleeping.top().wake <= current_time) {
+				task_ref t = sleeping.top().task;
+				sleeping.pop();
+				if (lookup(t) != nullptr) {
+					ready.push_back(t);
+				}
+			}
+		}
+
+		void poll_awaiting() {
+			std::size_t kept = 0;
+			for (std::size_t i = 0; i < awaiting.size(); ++i) {
+				task_ref t = awaiting[i];
+				task_entry* entry = lookup(t);
+				if (entry == nullptr) {
+					continue;
+				}
+				if (entry->awaited->ready()) {
+					ready.push_back(t);
+					continue;
+				}
+				awaiting[kept++] = t;
+			}
+			awaiting.resize(kept);
+		}
+
+		static scheduler& self(lua_State* L) {
+			// scripts can keep the library table around, so the handle is cleared when the scheduler goes away
+			scheduler* s = *static_cast<scheduler**>(lua_touserdata(L, lua_upvalueindex(1)));
+			if (s == nullptr) {
+				luaL_error(L, "sol: the scheduler this function belongs to has been destroyed");
+			}
+			return *s;
+		}
+
+		static scheduler& running_self(lua_State* L, const char* what) {
+			scheduler& s = self(L);
+			if (s.current != L) {
+				luaL_error(L, "sol: %s can only be called from a task run by the scheduler", what);
+			}
+			return s;
+		}
+
+		static int lua_wait(lua_State* L) {
+			scheduler& s = running_self(L, "wait");
+			s.pending = wait_kind::sleep;
+			s.pending_wake = s.current_time + static_cast<double>(luaL_optnumber(L, 1, 0));
+			return lua_yield(L, 0);
+		}
+
+		static int lua_wait_signal(lua_State* L) {
+			std::size_t len;
+			const char* name = luaL_checklstring(L, 1, &len);
+			scheduler& s = running_self(L, "wait_signal");
+			s.pending = wait_kind::signal;
+			s.pending_signal.assign(name, len);
+			return lua_yield(L, 0);
+		}
+
+		static int lua_await(lua_State* L) {
+			running_self(L, "await");
+			if (!detail::is_pending_await(L, 1)) {
+				return luaL_argerror(L, 1, "expected a value returned by an awaitable C++ function");
+			}
+			lua_settop(L, 1);
+			return lua_yield(L, 1);
+		}
+
+		static int lua_signal(lua_State* L) {
+			std::size_t len;
+			const char* name = luaL_checklstring(L, 1, &len);
+			scheduler& s = self(L);
+			int nargs = lua_gettop(L) - 1;
+			lua_pushinteger(L, static_cast<lua_Integer>(s.signal_with(std::string(name, len), [L, nargs](lua_State* co) {
+				for (int i = 0; i < nargs; ++i) {
+					lua_pushvalue(L, 2 + i);
+				}
+				lua_xmove(L, co, nargs);
+				return nargs;
+			})));
+			return 1;
+		}
+
+		static int lua_spawn(lua_State* L) {
+			luaL_checktype(L, 1, LUA_TFUNCTION);
+			scheduler& s = self(L);
+			int nargs = lua_gettop(L) - 1;
+			task_ref t = s.allocate(s.pool.acquire());
+			task_entry& entry = s.tasks[t.slot];
+			lua_xmove(L, entry.co, nargs + 1);
+			entry.nargs = nargs;
+			s.ready.push_back(t);
+			lua_pushinteger(L, static_cast<lua_Integer>(to_id(t)));
+			return 1;
+		}
+
+		template <typename Pusher>
+		std::size_t signal_with(const std::string& name, Pusher&& push_args) {
+			auto it = waiting.find(name);
+			if (it == waiting.end()) {
+				return 0;
+			}
+			std::vector<task_ref> woken = std::move(it->second);
+			waiting.erase(it);
+			std::size_t count = 0;
+			for (task_ref t : woken) {
+				task_entry* entry = lookup(t);
+				if (entry == nullptr) {
+					continue;
+				}
+				entry->signalled = false;
+				entry->signal.clear();
+				entry->nargs = push_args(entry->co);
+				ready.push_back(t);
+				++count;
+			}
+			return count;
+		}
+
+		void open_library() {
+			static const luaL_Reg functions[] = {
+				{ "wait", &lua_wait },
+				{ "wait_signal", &lua_wait_signal },
+				{ "await", &lua_await },
+				{ "signal", &lua_signal },
+				{ "spawn", &lua_spawn },
+				{ nullptr, nullptr }
+			};
+			handle = static_cast<scheduler**>(lua_newuserdata(L, sizeof(scheduler*)));
+			*handle = this;
+			handle_ref = reference(L, -1);
+			int handleindex = lua_gettop(L);
+			lua_createtable(L, 0, 5);
+			for (const luaL_Reg* f = functions; f->name != nullptr; ++f) {
+				lua_pushvalue(L, handleindex);
+				lua_pushcclosure(L, f->func, 1);
+				lua_setfield(L, -2, f->name);
+			}
+			lua_setglobal(L, library.c_str());
+			lua_pop(L, 1);
+		}
+
+	public:
+		scheduler(lua_State* L, std::string name = "scheduler", std::size_t pooled_threads = 256) : L(L), library(std::move(name)), pool(L, pooled_threads) {
+			open_library();
+		}
+
+		scheduler(const scheduler&) = delete;
+		scheduler& operator=(const scheduler&) = delete;
+
+		~scheduler() {
+			// the library functions may outlive this object, so they are cut off from it
+			*handle = nullptr;
+			lua_pushnil(L);
+			lua_setglobal(L, library.c_str());
+		}
+
+		template <typename Fx, typename... Args>
+		task_id spawn(Fx&& fx, Args&&... args) {
+			task_ref t = allocate(pool.acquire());
+			task_entry& entry = tasks[t.slot];
+			stack::push(entry.co, std::forward<Fx>(fx));
+			entry.nargs = stack::multi_push(entry.co, std::forward<Args>(args)...);
+			ready.push_back(t);
+			return to_id(t);
+		}
+
+		template <typename... Args>
+		std::size_t signal(const std::string& name, Args&&... args) {
+			return signal_with(name, [&](lua_State* co) {
+				return stack::multi_push(co, args...);
+			});
+		}
+
+		bool cancel(task_id id) {
+			task_ref t = to_ref(id);
+			task_entry* entry = lookup(t);
+			if (entry == nullptr || entry->co == current) {
+				return false;
+			}
+			task_result result;
+			result.cancelled = true;
+			complete(t, result);
+			return true;
+		}
+
+		template <typename Fx>
+		bool on_finish(task_id id, Fx&& fx) {
+			task_entry* entry = lookup(to_ref(id));
+			if (entry == nullptr) {
+				return false;
+			}
+			entry->finishers.emplace_back(std::forward<Fx>(fx));
+			return true;
+		}
+
+		bool alive(task_id id) {
+			return lookup(to_ref(id)) != nullptr;
+		}
+
+		std::size_t tick(double dt = 0) {
+			current_time += dt;
+			wake_sleepers();
+			poll_awaiting();
+			clock::time_point deadline = clock::now() + max_time;
+			bool timed = max_time != clock::duration::zero();
+			// only the tasks that were ready when the tick started run in it,
+			// so a task that yields to the next tick cannot starve the others
+			std::size_t runnable = ready.size();
+			std::size_t resumed = 0;
+			while (runnable-- > 0) {
+				if (max_resumes != 0 && resumed >= max_resumes) {
+					break;
+				}
+				if (timed && resumed != 0 && clock::now() >= deadline) {
+					break;
+				}
+				task_ref t = ready.front();
+				ready.pop_front();
+				if (lookup(t) == nullptr) {
+					continue;
+				}
+				++resumed;
+				run(t);
+			}
+			return resumed;
+		}
+
+		void set_max_resumes(std::size_t count) {
+			max_resumes = count;
+		}
+
+		template <typename Rep, typename Period>
+		void set_max_time(std::chrono::duration<Rep, Period> budget) {
+			max_time = std::chrono::duration_cast<clock::duration>(budget);
+		}
+
+		void set_execution_limit(const execution_limit& per_resume) {
+			limit = per_resume;
+		}
+
+		template <typename Fx>
+		void set_error_handler(Fx&& fx) {
+			on_error = std::forward<Fx>(fx);
+		}
+
+		double now() const {
+			return current_time;
+		}
+
+		std::size_t size() const {
+			return live;
+		}
+
+		bool empty() const {
+			return live == 0;
+		}
+
+		lua_State* lua_state() const {
+			return L;
+		}
+	};
+} // sol
+
+#endif // SOL_SCHEDULER_HPP
@@ -0,0 +1,542 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_SERIALIZE_HPP
+#define SOL_SERIALIZE_HPP
+
+#include "stack.hpp"
+#include "object.hpp"
+#include "usertype_traits.hpp"
+#include "transfer.hpp"
+#include "error.hpp"
+#include <unordered_map>
+#include <string>
+#include <cstring>
+#include <climits>
+#include <cstdint>
+#include <type_traits>
+
+namespace sol {
+	namespace detail {
+		enum class binary_tag : unsigned char {
+			nil,
+			boolean_false,
+			boolean_true,
+			integer,
+			number,
+			string,
+			table,
+			reference,
+			usertype
+		};
+
+		const int binary_max_depth = 200;
+
+		typedef void(*usertype_save_function)(lua_State* L, int index);
+		typedef void(*usertype_load_function)(lua_State* L, int index);
+
+		struct usertype_serializer_entry {
+			const std::string* name;
+			usertype_save_function save;
+			usertype_load_function load;
+		};
+
+		inline const char* serializer_registry() {
+			return "sol.serialize";
+		}
+
+		// looks up the key on top of the stack (and pops it) in the registered serializers
+		inline const usertype_serializer_entry* find_usertype_serializer(lua_State* L) {
+			lua_getfield(L, LUA_REGISTRYINDEX, serializer_registry());
+			if (!lua_istable(L, -1)) {
+				lua_pop(L, 2);
+				return nullptr;
+			}
+			lua_insert(L, -2);
+			lua_rawget(L, -2);
+			const usertype_serializer_entry* entry = static_cast<const usertype_serializer_entry*>(lua_touserdata(L, -1));
+			lua_pop(L, 2);
+			return entry;
+		}
+
+		// Values are written as a one byte tag and a payload: integers as zigzag varints,
+		// other numbers as raw doubles, strings and tables with their sizes up front, and usertypes
+		// as their name followed by whatever value their serializer turned them into.
+		// Each table and usertype gets a number the first time it is written, and any later
+		// occurrence is written as a reference to that number, which keeps cycles and shared objects.
+		class binary_writer {
+		private:
+			lua_State* L;
+			std::string& out;
+			std::unordered_map<const void*, std::uint32_t> seen;
+			std::uint32_t next_id = 0;
+			int depth = 0;
+
+			void put_tag(binary_tag tag) {
+				out.push_back(static_cast<char>(tag));
+			}
+
+			void put_varint(std::uint64_t value) {
+				while (value >= 0x80) {
+					out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+					value >>= 7;
+				}
+				out.push_back(static_cast<char>(value));
+			}
+
+			void put_bytes(const void* data, std::size_t size) {
+				out.append(static_cast<const char*>(data), size);
+			}
+
+			const char* write_table(int index) {
+				const void* source = lua_topointer(L, index);
+				auto it = seen.find(source);
+				if (it != seen.end()) {
+					put_tag(binary_tag::reference);
+					put_varint(it->second);
+					return nullptr;
+				}
+				if (depth >= binary_max_depth) {
+					return "sol: value is nested too deeply to serialize";
+				}
+				seen.emplace(source, next_id++);
+				luaL_checkstack(L, 3, "not enough space to serialize a table");
+				std::size_t length = lua_rawlen(L, index);
+				std::uint64_t narr = 0;
+				std::uint64_t nrec = 0;
+				lua_pushnil(L);
+				while (lua_next(L, index) != 0) {
+					lua_pop(L, 1);
+#if SOL_LUA_VERSION >= 503
+					bool integral = lua_isinteger(L, -1) != 0;
+#else
+					bool integral = lua_type(L, -1) == LUA_TNUMBER && lua_tonumber(L, -1) == static_cast<lua_Number>(lua_tointeger(L, -1));
+#endif // integer subtype
+					lua_Integer key = integral ? lua_tointeger(L, -1) : 0;
+					if (integral && key >= 1 && static_cast<std::size_t>(key) <= length) {
+						++narr;
+					}
+					else {
+						++nrec;
+					}
+				}
+				put_tag(binary_tag::table);
+				put_varint(narr);
+				put_varint(nrec);
+				++depth;
+				lua_pushnil(L);
+				while (lua_next(L, index) != 0) {
+					int value = lua_gettop(L);
+					const char* err = write(value - 1);
+					if (err == nullptr) {
+						err = write(value);
+					}
+					if (err != nullptr) {
+						lua_pop(L, 2);
+						return err;
+					}
+					lua_pop(L, 1);
+				}
+				--depth;
+				return nullptr;
+			}
+
+			const char* write_usertype(int index) {
+				const void* source = lua_topointer(L, index);
+				auto it = seen.find(source);
+				if (it != seen.end()) {
+					put_tag(binary_tag::reference);
+					put_varint(it->second);
+					return nullptr;
+				}
+				if (depth >= binary_max_depth) {
+					return "sol: value is nested too deeply to serialize";
+				}
+				luaL_checkstack(L, 3, "not enough space to serialize a usertype");
+				if (lua_getmetatable(L, index) == 0) {
+					return unsupported();
+				}
+				const usertype_serializer_entry* entry = find_usertype_serializer(L);
+				if (entry == nullptr) {
+					return unsupported();
+				}
+				put_tag(binary_tag::usertype);
+				put_varint(entry->name->size());
+				put_bytes(entry->name->data(), entry->name->size());
+				entry->save(L, index);
+				++depth;
+				const char* err = write(lua_gettop(L));
+				--depth;
+				lua_pop(L, 1);
+				// numbered after its contents, because that is the earliest the reader can number it
+				seen.emplace(source, next_id++);
+				return err;
+			}
+
+			static const char* unsupported() {
+				return "sol: cannot serialize a value of this type";
+			}
+
+		public:
+			binary_writer(lua_State* L, std::string& out) : L(L), out(out) {}
+
+			const char* write(int index) {
+				index = lua_absindex(L, index);
+				switch (lua_type(L, index)) {
+				case LUA_TNIL:
+					put_tag(binary_tag::nil);
+					return nullptr;
+				case LUA_TBOOLEAN:
+					put_tag(lua_toboolean(L, index) != 0 ? binary_tag::boolean_true : binary_tag::boolean_false);
+					return nullptr;
+				case LUA_TNUMBER: {
+#if SOL_LUA_VERSION >= 503
+					if (lua_isinteger(L, index)) {
+						std::uint64_t value = static_cast<std::uint64_t>(lua_tointeger(L, index));
+						put_tag(binary_tag::integer);
+						put_varint((value << 1) ^ (0 - (value >> 63)));
+						return nullptr;
+					}
+#endif // integers keep their subtype
+					double value = static_cast<double>(lua_tonumber(L, index));
+					put_tag(binary_tag::number);
+					put_bytes(&value, sizeof(value));
+					return nullptr;
+				}
+				case LUA_TSTRING: {
+					std::size_t len;
+					const char* str = lua_tolstring(L, index, &len);
+					put_tag(binary_tag::string);
+					put_varint(len);
+					put_bytes(str, len);
+					return nullptr;
+				}
+				case LUA_TTABLE:
+					return write_table(index);
+				case LUA_TUSERDATA:
+					return write_usertype(index);
+				default:
+					return unsupported();
+				}
+			}
+		};
+
+		class binary_reader {
+		private:
+			lua_State* L;
+			const char* current;
+			const char* last;
+			int tables;
+			lua_Integer next_id = 0;
+			int depth = 0;
+
+			bool get_varint(std::uint64_t& value) {
+				value = 0;
+				for (int shift = 0; shift < 64; shift += 7) {
+					if (current == last) {
+						return false;
+					}
+					unsigned char byte = static_cast<unsigned char>(*current++);
+					value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+					if ((byte & 0x80) == 0) {
+						return true;
+					}
+				}
+				return false;
+			}
+
+			bool get_bytes(void* data, std::size_t size) {
+				if (static_cast<std::size_t>(last - current) < size) {
+					return false;
+				}
+				std::memcpy(data, current, size);
+				current += size;
+				return true;
+			}
+
+			const char* read_table() {
+				std::uint64_t narr;
+				std::uint64_t nrec;
+				if (!get_varint(narr) || !get_varint(nrec)) {
+					return truncated();
+				}
+				// every entry takes at least two bytes, which rejects absurd sizes before allocating;
+				// the counts are checked one at a time so that their sum cannot wrap around
+				std::uint64_t most = static_cast<std::uint64_t>(last - current) / 2;
+				if (narr > most || nrec > most - narr) {
+					return truncated();
+				}
+				if (narr > static_cast<std::uint64_t>(INT_MAX) || nrec > static_cast<std::uint64_t>(INT_MAX)) {
+					return truncated();
+				}
+				if (depth >= binary_max_depth) {
+					return "sol: serialized data is nested too deeply";
+				}
+				luaL_checkstack(L, 4, "not enough space to deserialize a table");
+				lua_createtable(L, static_cast<int>(narr), static_cast<int>(nrec));
+				int table = lua_gettop(L);
+				lua_pushvalue(L, table);
+				lua_rawseti(L, tables, ++next_id);
+				++depth;
+				for (std::uint64_t i = 0; i < narr + nrec; ++i) {
+					const char* err = read();
+					if (err == nullptr) {
+						err = read();
+					}
+					if (err != nullptr) {
+						return err;
+					}
+					if (lua_isnil(L, -2) || (lua_type(L, -2) == LUA_TNUMBER && lua_tonumber(L, -2) != lua_tonumber(L, -2))) {
+						return "sol: serialized data has an invalid table key";
+					}
+					lua_rawset(L, table);
+				}
+				--depth;
+				return nullptr;
+			}
+
+			const char* read_usertype() {
+				std::uint64_t len;
+				if (!get_varint(len) || len > static_cast<std::uint64_t>(last - current)) {
+					return truncated();
+				}
+				const char* name = current;
+				current += len;
+				if (depth >= binary_max_depth) {
+					return "sol: serialized data is nested too deeply";
+				}
+				luaL_checkstack(L, 3, "not enough space to deserialize a usertype");
+				++depth;
+				const char* err = read();
+				--depth;
+				if (err != nullptr) {
+					return err;
+				}
+				lua_pushlstring(L, name, static_cast<std::size_t>(len));
+				const usertype_serializer_entry* entry = find_usertype_serializer(L);
+				if (entry == nullptr) {
+					return "sol: serialized data has a usertype with no registered serializer";
+				}
+				int saved = lua_gettop(L);
+				entry->load(L, saved);
+				lua_remove(L, saved);
+				lua_pushvalue(L, -1);
+				lua_rawseti(L, tables, ++next_id);
+				return nullptr;
+			}
+
+			static const char* truncated() {
+				return "sol: serialized data is truncated or corrupt";
+			}
+
+		public:
+			binary_reader(lua_State* L, const char* data, std::size_t size) : L(L), current(data), last(data + size), tables(0) {}
+
+			// pushes exactly one value on success; on failure, the values pushed so far are left for the caller to drop
+			const char* read() {
+				if (tables == 0) {
+					lua_newtable(L);
+					tables = lua_gettop(L);
+				}
+				if (current == last) {
+					return truncated();
+				}
+				binary_tag tag = static_cast<binary_tag>(*current++);
+				switch (tag) {
+				case binary_tag::nil:
+					lua_pushnil(L);
+					return nullptr;
+				case binary_tag::boolean_false:
+				case binary_tag::boolean_true:
+					lua_pushboolean(L, tag == binary_tag::boolean_true);
+					return nullptr;
+				case binary_tag::integer: {
+					std::uint64_t zigzag;
+					if (!get_varint(zigzag)) {
+						return truncated();
+					}
+					lua_pushinteger(L, static_cast<lua_Integer>((zigzag >> 1) ^ (0 - (zigzag & 1))));
+					return nullptr;
+				}
+				case binary_tag::number: {
+					double value;
+					if (!get_bytes(&value, sizeof(value))) {
+						return truncated();
+					}
+					lua_pushnumber(L, static_cast<lua_Number>(value));
+					return nullptr;
+				}
+				case binary_tag::string: {
+					std::uint64_t len;
+					if (!get_varint(len) || len > static_cast<std::uint64_t>(last - current)) {
+						return truncated();
+					}
+					lua_pushlstring(L, current, static_cast<std::size_t>(len));
+					current += len;
+					return nullptr;
+				}
+				case binary_tag::table:
+					return read_table();
+				case binary_tag::usertype:
+					return read_usertype();
+				case binary_tag::reference: {
+					std::uint64_t id;
+					if (!get_varint(id) || id >= static_cast<std::uint64_t>(next_id)) {
+						return truncated();
+					}
+					lua_rawgeti(L, tables, static_cast<lua_Integer>(id) + 1);
+					return nullptr;
+				}
+				default:
+					return truncated();
+				}
+			}
+
+			bool at_end() const {
+				return current == last;
+			}
+		};
+
+		// leaves the decoded value on top of the stack, or nothing and an error message
+		inline const char* binary_decode(lua_State* L, const char* data, std::size_t size) {
+			int top = lua_gettop(L);
+			binary_reader reader(L, data, size);
+			const char* err = reader.read();
+			if (err == nullptr && !reader.at_end()) {
+				err = "sol: serialized data has trailing bytes";
+			}
+			if (err != nullptr) {
+				lua_settop(L, top);
+				return err;
+			}
+			lua_replace(L, top + 1);
+			lua_settop(L, top + 1);
+			return nullptr;
+		}
+
+		template <typename T>
+		void save_usertype(lua_State* L, int index) {
+			usertype_serializer<T>::save(L, *stack::get<T*>(L, index));
+		}
+
+		template <typename T>
+		void load_usertype(lua_State* L, int index) {
+			stack::push(L, usertype_serializer<T>::load(L, index));
+		}
+
+		template <typename T>
+		const usertype_serializer_entry* usertype_serializer_entry_for() {
+			static const usertype_serializer_entry entry{ &usertype_traits<T>::qualified_name(), &save_usertype<T>, &load_usertype<T> };
+			return &entry;
+		}
+
+		inline void serialize_fail(const char* message) {
+#ifndef SOL_NO_EXCEPTIONS
+			throw error(message);
+#else
+			(void)message;
+#endif // No Exceptions
+		}
+	} // detail
+
+	template <typename T>
+	struct trivial_usertype_serializer {
+		static_assert(std::is_trivially_copyable<T>::value, "sol::trivial_usertype_serializer can only be used with trivially copyable types");
+
+		static void save(lua_State* L, const T& value) {
+			lua_pushlstring(L, reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		static T load(lua_State* L, int index) {
+			T value{};
+			std::size_t len = 0;
+			const char* data = lua_tolstring(L, index, &len);
+			if (data == nullptr || len != sizeof(T)) {
+				detail::serialize_fail("sol: serialized usertype has the wrong size");
+				return value;
+			}
+			std::memcpy(&value, data, sizeof(T));
+			return value;
+		}
+	};
+
+	template <typename T>
+	void register_serializer(lua_State* L) {
+		const detail::usertype_serializer_entry* entry = detail::usertype_serializer_entry_for<T>();
+		int registryindex = detail::push_usertype_registry<T>(L, detail::serializer_registry(), entry);
+		// loading finds the serializer by the name written in the data
+		stack::push(L, usertype_traits<T>::qualified_name());
+		lua_pushlightuserdata(L, const_cast<detail::usertype_serializer_entry*>(entry));
+		lua_rawset(L, registryindex);
+		lua_pop(L, 1);
+	}
+
+	inline void serialize(lua_State* L, int index, std::string& buffer) {
+		detail::settop_on_exit restore{ L, lua_gettop(L) };
+		std::size_t size = buffer.size();
+		const char* err = detail::binary_writer(L, buffer).write(index);
+		if (err != nullptr) {
+			buffer.resize(size);
+			detail::serialize_fail(err);
+		}
+	}
+
+	inline void serialize(const object& value, std::string& buffer) {
+		lua_State* L = value.lua_state();
+		detail::settop_on_exit restore{ L, lua_gettop(L) };
+		value.push();
+		serialize(L, -1, buffer);
+	}
+
+	inline std::string serialize(const object& value) {
+		std::string buffer;
+		serialize(value, buffer);
+		return buffer;
+	}
+
+	inline object deserialize(lua_State* L, const char* data, std::size_t size) {
+#ifndef SOL_NO_EXCEPTIONS
+		int top = lua_gettop(L);
+		const char* err;
+		try {
+			err = detail::binary_decode(L, data, size);
+		}
+		catch (...) {
+			lua_settop(L, top);
+			throw;
+		}
+#else
+		const char* err = detail::binary_decode(L, data, size);
+#endif // No Exceptions
+		if (err != nullptr) {
+			detail::serialize_fail(err);
+			return object(lua_nil);
+		}
+		return stack::pop<object>(L);
+	}
+
+	inline object deserialize(lua_State* L, const std::string& bytes) {
+		return deserialize(L, bytes.data(), bytes.size());
+	}
+} // sol
+
+#endif // SOL_SERIALIZE_HPP
@@ -0,0 +1,271 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_SOA_HPP
+#define SOL_SOA_HPP
+
+#include "stack.hpp"
+#include "buffer.hpp"
+#include "container_usertype_metatable.hpp"
+#include <tuple>
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <string>
+#include <utility>
+
+namespace sol {
+
+	template <typename T>
+	struct soa_row {
+		T* store;
+		std::size_t row;
+	};
+
+	template <typename T, typename... Tn>
+	struct soa_metatable {
+		typedef std::make_index_sequence<sizeof...(Tn) / 2> indices;
+		typedef std::unordered_map<std::string, std::size_t> column_map;
+
+		std::tuple<Tn...> layout;
+		column_map columns;
+
+		template <std::size_t... I>
+		void map_columns(std::index_sequence<I...>) {
+			detail::swallow{ 0, (columns.emplace(std::get<I * 2>(layout), I), 0)... };
+		}
+
+		template <typename... Args>
+		soa_metatable(Args&&... args) : layout(std::forward<Args>(args)...) {
+			static_assert(sizeof...(Tn) % 2 == 0, "sol::soa layouts must be given as \"name\", &T::column pairs");
+			columns.reserve(sizeof...(Tn) / 2);
+			map_columns(indices());
+		}
+
+		template <typename F>
+		void visit_column(std::index_sequence<>, std::size_t, F&&) {}
+
+		template <std::size_t I, std::size_t... In, typename F>
+		void visit_column(std::index_sequence<I, In...>, std::size_t which, F&& f) {
+			if (which == I) {
+				f(std::get<I * 2 + 1>(layout));
+				return;
+			}
+			visit_column(std::index_sequence<In...>(), which, std::forward<F>(f));
+		}
+
+		template <typename F>
+		bool visit_column(lua_State* L, int keyindex, F&& f) {
+			if (type_of(L, keyindex) != type::string) {
+				return false;
+			}
+			auto it = columns.find(stack::get<std::string>(L, keyindex));
+			if (it == columns.cend()) {
+				return false;
+			}
+			visit_column(indices(), it->second, std::forward<F>(f));
+			return true;
+		}
+
+		template <std::size_t... I>
+		std::size_t rows(std::index_sequence<I...>, T& store) {
+			std::size_t n = (std::numeric_limits<std::size_t>::max)();
+			detail::swallow{ 0, (n = (std::min)(n, (store.*std::get<I * 2 + 1>(layout)).size()), 0)... };
+			return n;
+		}
+
+		std::size_t rows(T& store) {
+			// The columns are resized from C++, so the shortest one decides how many rows are usable
+			return rows(indices(), store);
+		}
+
+		static soa_metatable& get_metatable(lua_State* L) {
+			return stack::get<user<soa_metatable>>(L, upvalue_index(1));
+		}
+
+		static T& get_store(lua_State* L) {
+			T* store = stack::get<non_null<T*>>(L, 1);
+			return *store;
+		}
+
+		static int push_row(lua_State* L, T& store, std::size_t row) {
+			// Row handles are cached in the store's user value and re-pointed on access,
+			// so walking the rows every frame does not allocate
+			lua_getuservalue(L, 1);
+			if (type_of(L, -1) != type::table) {
+				lua_pop(L, 1);
+				lua_createtable(L, 0, 0);
+				lua_pushvalue(L, -1);
+				lua_setuservalue(L, 1);
+			}
+			lua_rawgeti(L, -1, static_cast<lua_Integer>(row));
+			if (type_of(L, -1) == type::userdata) {
+				soa_row<T>* handle = static_cast<soa_row<T>*>(lua_touserdata(L, -1));
+				handle->store = &store;
+			}
+			else {
+				lua_pop(L, 1);
+				void* rawdata = lua_newuserdata(L, sizeof(soa_row<T>));
+				new (rawdata) soa_row<T>{ &store, row };
+				luaL_getmetatable(L, &usertype_traits<soa_row<T>>::metatable()[0]);
+				lua_setmetatable(L, -2);
+				lua_pushvalue(L, -1);
+				lua_rawseti(L, -3, static_cast<lua_Integer>(row));
+			}
+			lua_remove(L, -2);
+			return 1;
+		}
+
+		static int store_index_call(lua_State* L) {
+			soa_metatable& smt = get_metatable(L);
+			T& store = get_store(L);
+			if (type_of(L, 2) == type::number) {
+				lua_Integer row = stack::get<lua_Integer>(L, 2);
+				if (row < 1 || static_cast<std::size_t>(row) > smt.rows(store)) {
+					return stack::push(L, lua_nil);
+				}
+				return push_row(L, store, static_cast<std::size_t>(row));
+			}
+			int pushed = 0;
+			bool found = smt.visit_column(L, 2, [&](auto column) {
+				pushed = stack::push(L, make_buffer(store.*column));
+			});
+			if (!found) {
+				return stack::push(L, lua_nil);
+			}
+			return pushed;
+		}
+
+		static int store_new_index_call(lua_State* L) {
+			return luaL_error(L, "sol: cannot assign to the columns or rows of a %s; write through its rows or column buffers instead", detail::demangle<T>().c_str());
+		}
+
+		static int store_length_call(lua_State* L) {
+			soa_metatable& smt = get_metatable(L);
+			return stack::push(L, smt.rows(get_store(L)));
+		}
+
+		static int row_index_call(lua_State* L) {
+			soa_metatable& smt = get_metatable(L);
+			soa_row<T>& handle = *static_cast<soa_row<T>*>(lua_touserdata(L, 1));
+			int pushed = 0;
+			bool inrange = true;
+			bool found = smt.visit_column(L, 2, [&](auto column) {
+				auto& values = (*handle.store).*column;
+				inrange = handle.row <= values.size();
+				if (inrange) {
+					pushed = stack::push(L, values[handle.row - 1]);
+				}
+			});
+			if (!found) {
+				return stack::push(L, lua_nil);
+			}
+			if (!inrange) {
+				return luaL_error(L, "sol: row %d of %s is out of range (the columns were shrunk)", static_cast<int>(handle.row), detail::demangle<T>().c_str());
+			}
+			return pushed;
+		}
+
+		static int row_new_index_call(lua_State* L) {
+			soa_metatable& smt = get_metatable(L);
+			soa_row<T>& handle = *static_cast<soa_row<T>*>(lua_touserdata(L, 1));
+			bool inrange = true;
+			bool found = smt.visit_column(L, 2, [&](auto column) {
+				auto& values = (*handle.store).*column;
+				typedef typename meta::unqualified_t<decltype(values)>::value_type V;
+				inrange = handle.row <= values.size();
+				if (inrange) {
+					values[handle.row - 1] = stack::get<V>(L, 3);
+				}
+			});
+			if (!found) {
+				return luaL_error(L, "sol: '%s' is not a column of %s", stack::get<std::string>(L, 2).c_str(), detail::demangle<T>().c_str());
+			}
+			if (!inrange) {
+				return luaL_error(L, "sol: row %d of %s is out of range (the columns were shrunk)", static_cast<int>(handle.row), detail::demangle<T>().c_str());
+			}
+			return 0;
+		}
+
+		static int store_index(lua_State* L) {
+			return detail::static_trampoline<&store_index_call>(L);
+		}
+
+		static int store_new_index(lua_State* L) {
+			return detail::static_trampoline<&store_new_index_call>(L);
+		}
+
+		static int store_length(lua_State* L) {
+			return detail::static_trampoline<&store_length_call>(L);
+		}
+
+		static int row_index(lua_State* L) {
+			return detail::static_trampoline<&row_index_call>(L);
+		}
+
+		static int row_new_index(lua_State* L) {
+			return detail::static_trampoline<&row_new_index_call>(L);
+		}
+
+		static void set_metatable(lua_State* L, const std::string& key, const luaL_Reg* reg) {
+			luaL_newmetatable(L, &key[0]);
+			lua_pushvalue(L, -2);
+			luaL_setfuncs(L, reg, 1);
+			lua_pop(L, 1);
+		}
+
+		static void register_into(lua_State* L, soa_metatable&& smt) {
+			static const luaL_Reg valuereg[] = {
+				{ "__index", &store_index },
+				{ "__newindex", &store_new_index },
+				{ "__len", &store_length },
+				{ "__gc", &detail::usertype_alloc_destroy<T> },
+				{ nullptr, nullptr }
+			};
+			static const luaL_Reg pointerreg[] = {
+				{ "__index", &store_index },
+				{ "__newindex", &store_new_index },
+				{ "__len", &store_length },
+				{ nullptr, nullptr }
+			};
+			static const luaL_Reg rowreg[] = {
+				{ "__index", &row_index },
+				{ "__newindex", &row_new_index },
+				{ nullptr, nullptr }
+			};
+			stack::push<user<soa_metatable>>(L, std::move(smt));
+			set_metatable(L, usertype_traits<T>::metatable(), valuereg);
+			set_metatable(L, usertype_traits<T*>::metatable(), pointerreg);
+			set_metatable(L, usertype_traits<soa_row<T>>::metatable(), rowreg);
+			lua_pop(L, 1);
+		}
+	};
+
+	template <typename T, typename... Args>
+	void register_soa(lua_State* L, Args&&... args) {
+		typedef soa_metatable<T, std::decay_t<Args>...> smt_t;
+		smt_t::register_into(L, smt_t(std::forward<Args>(args)...));
+	}
+
+} // sol
+
+#endif // SOL_SOA_HPP
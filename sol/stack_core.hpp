@@ -31,6 +31,7 @@
 #include "stack_guard.hpp"
 #include <vector>
 #include <string>
+#include <array>
 
 #include "file_begin.hpp"
 
@@ -59,7 +60,7 @@ namespace sol {
 			unique_destructor* dx = static_cast<unique_destructor*>(static_cast<void*>(pointerpointer + 1));
 			Real* target = static_cast<Real*>(static_cast<void*>(dx + 1));
 			std::allocator<Real> alloc;
-			alloc.destroy(target);
+			std::allocator_traits<std::allocator<Real>>::destroy(alloc, target);
 		}
 
 		template <typename T>
@@ -67,7 +68,7 @@ namespace sol {
 			void* rawdata = lua_touserdata(L, 1);
 			T* data = static_cast<T*>(rawdata);
 			std::allocator<T> alloc;
-			alloc.destroy(data);
+			std::allocator_traits<std::allocator<T>>::destroy(alloc, data);
 			return 0;
 		}
 
@@ -77,21 +78,34 @@ namespace sol {
 			T** pdata = static_cast<T**>(rawdata);
 			T* data = *pdata;
 			std::allocator<T> alloc{};
-			alloc.destroy(data);
+			std::allocator_traits<std::allocator<T>>::destroy(alloc, data);
 			return 0;
 		}
 
 		template <typename T>
-		void reserve(T&, std::size_t) {}
+		struct has_reserve {
+		private:
+			typedef std::array<char, 1> one;
+			typedef std::array<char, 2> two;
 
-		template <typename T, typename Al>
-		void reserve(std::vector<T, Al>& arr, std::size_t hint) {
+			template <typename C> static one test(decltype(std::declval<C&>().reserve(std::declval<std::size_t>()))*);
+			template <typename C> static two test(...);
+
+		public:
+			static const bool value = sizeof(test<T>(0)) == sizeof(char);
+		};
+
+		template <typename T>
+		void reserve(std::false_type, T&, std::size_t) {}
+
+		template <typename T>
+		void reserve(std::true_type, T& arr, std::size_t hint) {
 			arr.reserve(hint);
 		}
 
-		template <typename T, typename Tr, typename Al>
-		void reserve(std::basic_string<T, Tr, Al>& arr, std::size_t hint) {
-			arr.reserve(hint);
+		template <typename T>
+		void reserve(T& arr, std::size_t hint) {
+			reserve(std::integral_constant<bool, has_reserve<T>::value>(), arr, hint);
 		}
 	} // detail
 
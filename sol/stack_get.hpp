@@ -90,32 +90,12 @@ namespace sol {
 
 				int index = lua_absindex(L, relindex);
 				T arr;
-#if SOL_LUA_VERSION >= 503
-				// This method is HIGHLY performant over regular table iteration thanks to the Lua API changes in 5.3
+				detail::reserve(arr, static_cast<std::size_t>(lua_rawlen(L, index)) / lua_size<V>::value);
+				// Raw accesses skip metamethods and, unlike lua_gettable, do not need the key pushed first
 				for (lua_Integer i = 0; ; i += lua_size<V>::value, lua_pop(L, lua_size<V>::value)) {
 					bool isnil = false;
 					for (int vi = 0; vi < lua_size<V>::value; ++vi) {
-						type t = static_cast<type>(lua_geti(L, index, i + vi));
-						isnil = t == type::lua_nil;
-						if (isnil) {
-							if (i == 0) {
-								break;
-							}
-							lua_pop(L, (vi + 1));
-							return arr;
-						}
-					}
-					if (isnil)
-						continue;
-					arr.push_back(stack::get<V>(L, -lua_size<V>::value));
-				}
-#else
-				// Zzzz slower but necessary thanks to the lower version API and missing functions qq
-				for (lua_Integer i = 0; ; i += lua_size<V>::value, lua_pop(L, lua_size<V>::value)) {
-					bool isnil = false;
-					for (int vi = 0; vi < lua_size<V>::value; ++vi) {
-						lua_pushinteger(L, i);
-						lua_gettable(L, index);
+						lua_rawgeti(L, index, i + vi);
 						type t = type_of(L, -1);
 						isnil = t == type::lua_nil;
 						if (isnil) {
@@ -128,9 +108,8 @@ namespace sol {
 					}
 					if (isnil)
 						continue;
-					arr.push_back(stack::get<V>(L, -1));
+					arr.push_back(stack::get<V>(L, -lua_size<V>::value));
 				}
-#endif
 				return arr;
 			}
 		};
@@ -150,6 +129,16 @@ namespace sol {
 
 				T associative;
 				int index = lua_absindex(L, relindex);
+				if (detail::has_reserve<T>::value) {
+					// Counting first is cheaper than rehashing the result as it grows
+					std::size_t count = 0;
+					lua_pushnil(L);
+					while (lua_next(L, index) != 0) {
+						++count;
+						lua_pop(L, 1);
+					}
+					detail::reserve(associative, count);
+				}
 				lua_pushnil(L);
 				while (lua_next(L, index) != 0) {
 					decltype(auto) key = stack::check_get<K>(L, -2);
@@ -272,6 +261,19 @@ namespace sol {
 			}
 		};
 
+#ifdef SOL_STD_STRING_VIEW
+		template <>
+		struct getter<std::string_view> {
+			// refers to the string on the stack, so it is only valid while that value is kept alive
+			static std::string_view get(lua_State* L, int index, record& tracking) {
+				tracking.use(1);
+				std::size_t len;
+				const char* str = lua_tolstring(L, index, &len);
+				return std::string_view(str, len);
+			}
+		};
+#endif // std::string_view
+
 		template <>
 		struct getter<string_detail::string_shim> {
 			string_detail::string_shim get(lua_State* L, int index, record& tracking) {
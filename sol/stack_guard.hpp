@@ -37,6 +37,14 @@ namespace sol {
 			// hopefully someone will register their own stack_fail thing for the `fx` parameter of stack_guard.
 #endif // No Exceptions
 		}
+
+		struct settop_on_exit {
+			lua_State* L;
+			int top;
+			~settop_on_exit() {
+				lua_settop(L, top);
+			}
+		};
 	} // detail
 
 	struct stack_guard {
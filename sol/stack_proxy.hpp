@@ -71,6 +71,11 @@ namespace sol {
 			static stack_proxy get(lua_State* L, int index = -1) {
 				return stack_proxy(L, index);
 			}
+
+			static stack_proxy get(lua_State* L, int index, record& tracking) {
+				tracking.use(1);
+				return stack_proxy(L, index);
+			}
 		};
 
 		template <>
@@ -70,7 +70,7 @@ namespace sol {
 				T* allocationtarget = reinterpret_cast<T*>(pointerpointer + 1);
 				referencereference = allocationtarget;
 				std::allocator<T> alloc{};
-				alloc.construct(allocationtarget, std::forward<Args>(args)...);
+				std::allocator_traits<std::allocator<T>>::construct(alloc, allocationtarget, std::forward<Args>(args)...);
 				f();
 				return 1;
 			}
@@ -224,21 +224,21 @@ namespace sol {
 #if SOL_LUA_VERSION >= 503
 					int p = stack::push(L, i);
 					for (int pi = 0; pi < p; ++pi) {
-						lua_seti(L, tableindex, static_cast<lua_Integer>(index++));
+						lua_rawseti(L, tableindex, static_cast<lua_Integer>(index++));
 					}
 #else
 					lua_pushinteger(L, static_cast<lua_Integer>(index));
 					int p = stack::push(L, i);
 					if (p == 1) {
 						++index;
-						lua_settable(L, tableindex);
+						lua_rawset(L, tableindex);
 					}
 					else {
 						int firstindex = tableindex + 1 + 1;
 						for (int pi = 0; pi < p; ++pi) {
 							stack::push(L, index);
 							lua_pushvalue(L, firstindex);
-							lua_settable(L, tableindex);
+							lua_rawset(L, tableindex);
 							++index;
 							++firstindex;
 						}
@@ -256,10 +256,10 @@ namespace sol {
 		struct pusher<as_table_t<T>, std::enable_if_t<meta::has_key_value_pair<meta::unqualified_t<std::remove_pointer_t<T>>>::value>> {
 			static int push(lua_State* L, const as_table_t<T>& tablecont) {
 				auto& cont = detail::deref(detail::unwrap(tablecont.source));
-				lua_createtable(L, static_cast<int>(cont.size()), 0);
+				lua_createtable(L, 0, static_cast<int>(cont.size()));
 				int tableindex = lua_gettop(L);
 				for (const auto& pair : cont) {
-					set_field(L, pair.first, pair.second, tableindex);
+					set_field<false, true>(L, pair.first, pair.second, tableindex);
 				}
 				return 1;
 			}
@@ -387,7 +387,7 @@ namespace sol {
 				void* rawdata = lua_newuserdata(L, sizeof(T));
 				T* data = static_cast<T*>(rawdata);
 				std::allocator<T> alloc;
-				alloc.construct(data, std::forward<Args>(args)...);
+				std::allocator_traits<std::allocator<T>>::construct(alloc, data, std::forward<Args>(args)...);
 				if (with_meta) {
 					lua_CFunction cdel = detail::user_alloc_destroy<T>;
 					// Make sure we have a plain GC set for this data
@@ -504,6 +504,16 @@ namespace sol {
 			}
 		};
 
+#ifdef SOL_STD_STRING_VIEW
+		template<>
+		struct pusher<std::string_view> {
+			static int push(lua_State* L, const std::string_view& str) {
+				lua_pushlstring(L, str.data(), str.size());
+				return 1;
+			}
+		};
+#endif // std::string_view
+
 		template<>
 		struct pusher<meta_function> {
 			static int push(lua_State* L, meta_function m) {
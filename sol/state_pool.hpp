@@ -0,0 +1,295 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_STATE_POOL_HPP
+#define SOL_STATE_POOL_HPP
+
+#include "state.hpp"
+#include <vector>
+#include <deque>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <atomic>
+#include <functional>
+
+namespace sol {
+	namespace detail {
+		inline int bytecode_writer(lua_State*, const void* p, std::size_t sz, void* ud) {
+			static_cast<std::string*>(ud)->append(static_cast<const char*>(p), sz);
+			return 0;
+		}
+
+		// dumps the function on top of the stack to a binary chunk
+		inline std::string dump_function(lua_State* L) {
+			std::string out;
+#if SOL_LUA_VERSION >= 503
+			lua_dump(L, &bytecode_writer, &out, 0);
+#else
+			lua_dump(L, &bytecode_writer, &out);
+#endif // Lua 5.3 can strip debug information
+			return out;
+		}
+
+		inline std::string compile(const std::string& code, const std::string& chunkname = "") {
+			state scratch;
+			load_result load = scratch.load_buffer(code.data(), code.size(), chunkname.c_str());
+			if (!load.valid()) {
+#ifndef SOL_NO_EXCEPTIONS
+				throw load.get<error>();
+#else
+				return std::string();
+#endif // No Exceptions
+			}
+			protected_function chunk = load;
+			auto pp = stack::push_pop(chunk);
+			return dump_function(scratch.lua_state());
+		}
+
+		template <typename R>
+		struct job_result {
+			static R get(lua_State* L, int index) {
+				return stack::get<R>(L, index);
+			}
+
+			static R failed() {
+				return R();
+			}
+		};
+
+		template <>
+		struct job_result<void> {
+			static void get(lua_State*, int) {}
+
+			static void failed() {}
+		};
+
+		template <typename R, typename Fx>
+		void fulfill(std::true_type, std::promise<R>& p, Fx&& fx) {
+			fx();
+			p.set_value();
+		}
+
+		template <typename R, typename Fx>
+		void fulfill(std::false_type, std::promise<R>& p, Fx&& fx) {
+			p.set_value(fx());
+		}
+
+		template <typename R, typename Fx>
+		void fulfill(std::promise<R>& p, Fx&& fx) {
+#ifndef SOL_NO_EXCEPTIONS
+			try {
+#endif // No Exceptions
+				fulfill(std::is_void<R>(), p, std::forward<Fx>(fx));
+#ifndef SOL_NO_EXCEPTIONS
+			}
+			catch (...) {
+				p.set_exception(std::current_exception());
+			}
+#endif // No Exceptions
+		}
+
+		template <typename Tuple, std::size_t... I>
+		int push_job_args(lua_State* L, Tuple& args, std::index_sequence<I...>) {
+			(void)args;
+			return stack::multi_push(L, std::get<I>(args)...);
+		}
+	} // detail
+
+	class state_pool {
+	public:
+		typedef std::function<void(state&)> job;
+
+	private:
+		struct worker {
+			state lua;
+			std::mutex lock;
+			std::deque<job> jobs;
+			std::thread runner;
+		};
+
+		std::vector<std::unique_ptr<worker>> workers;
+		std::mutex idle_lock;
+		std::condition_variable idle;
+		std::atomic<std::size_t> pending;
+		std::atomic<std::size_t> next;
+		bool stopping = false;
+
+		bool pop_own(worker& w, job& j) {
+			std::lock_guard<std::mutex> guard(w.lock);
+			if (w.jobs.empty()) {
+				return false;
+			}
+			j = std::move(w.jobs.front());
+			w.jobs.pop_front();
+			return true;
+		}
+
+		bool steal(std::size_t self, job& j) {
+			std::size_t n = workers.size();
+			for (std::size_t offset = 1; offset < n; ++offset) {
+				worker& victim = *workers[(self + offset) % n];
+				std::lock_guard<std::mutex> guard(victim.lock);
+				if (victim.jobs.empty()) {
+					continue;
+				}
+				// owners take from the front, thieves from the back, so they rarely want the same job
+				j = std::move(victim.jobs.back());
+				victim.jobs.pop_back();
+				return true;
+			}
+			return false;
+		}
+
+		void work(std::size_t self) {
+			worker& w = *workers[self];
+			job j;
+			for (;;) {
+				if (pop_own(w, j) || steal(self, j)) {
+					--pending;
+					j(w.lua);
+					j = nullptr;
+					continue;
+				}
+				std::unique_lock<std::mutex> guard(idle_lock);
+				idle.wait(guard, [this]() { return stopping || pending.load() != 0; });
+				if (stopping && pending.load() == 0) {
+					return;
+				}
+			}
+		}
+
+		void enqueue(std::size_t target, job j) {
+			worker& w = *workers[target % workers.size()];
+			// counted before it is published, so a worker that takes it right away cannot decrement past zero
+			{
+				std::lock_guard<std::mutex> guard(idle_lock);
+				++pending;
+			}
+			{
+				std::lock_guard<std::mutex> guard(w.lock);
+				w.jobs.push_back(std::move(j));
+			}
+			idle.notify_one();
+		}
+
+		static void run_chunk(state& lua, const std::string& bytecode) {
+			load_result load = lua.load_buffer(bytecode.data(), bytecode.size(), "=state_pool");
+			protected_function chunk = load;
+			protected_function_result result = chunk();
+			if (!result.valid()) {
+				default_on_error(lua.lua_state(), std::move(result));
+			}
+		}
+
+	public:
+		state_pool(std::size_t count, const std::function<void(state&)>& init, const std::string& code = std::string()) : pending(0), next(0) {
+			if (count == 0) {
+				count = 1;
+			}
+			// the script is compiled once, and every state only loads the bytecode
+			std::string bytecode = code.empty() ? code : detail::compile(code, "=state_pool");
+			workers.reserve(count);
+			// states are made on this thread, since constructing one sets the process-wide default error handler
+			for (std::size_t i = 0; i < count; ++i) {
+				workers.emplace_back(new worker());
+				state& lua = workers.back()->lua;
+				if (init) {
+					init(lua);
+				}
+				if (!bytecode.empty()) {
+					run_chunk(lua, bytecode);
+				}
+			}
+			for (std::size_t i = 0; i < count; ++i) {
+				workers[i]->runner = std::thread(&state_pool::work, this, i);
+			}
+		}
+
+		state_pool(const state_pool&) = delete;
+		state_pool& operator=(const state_pool&) = delete;
+
+		~state_pool() {
+			{
+				std::lock_guard<std::mutex> guard(idle_lock);
+				stopping = true;
+			}
+			idle.notify_all();
+			for (auto& w : workers) {
+				if (w->runner.joinable()) {
+					w->runner.join();
+				}
+			}
+		}
+
+		template <typename Fx>
+		auto submit_with(Fx&& fx) -> std::future<decltype(fx(std::declval<state&>()))> {
+			typedef decltype(fx(std::declval<state&>())) R;
+			auto p = std::make_shared<std::promise<R>>();
+			std::future<R> result = p->get_future();
+			auto f = std::make_shared<std::decay_t<Fx>>(std::forward<Fx>(fx));
+			enqueue(next++, [p, f](state& lua) {
+				detail::fulfill(*p, [&]() -> R { return (*f)(lua); });
+			});
+			return result;
+		}
+
+		template <typename R = void, typename... Args>
+		std::future<R> submit(std::string function_name, Args&&... args) {
+			static_assert(!is_lua_reference<R>::value, "results of a state_pool job must be plain C++ values: Lua references cannot leave the worker's state");
+			auto packed = std::make_shared<std::tuple<std::decay_t<Args>...>>(std::forward<Args>(args)...);
+			return submit_with([name = std::move(function_name), packed](state& lua) -> R {
+				lua_State* L = lua.lua_state();
+				int base = lua_gettop(L);
+				lua_pushcfunction(L, &default_error_handler);
+				lua_getglobal(L, name.c_str());
+				int nargs = detail::push_job_args(L, *packed, std::make_index_sequence<sizeof...(Args)>());
+				if (lua_pcall(L, nargs, LUA_MULTRET, base + 1) != LUA_OK) {
+					std::string message = lua_type(L, -1) == LUA_TSTRING ? lua_tostring(L, -1) : "sol: state_pool job failed";
+					lua_settop(L, base);
+#ifndef SOL_NO_EXCEPTIONS
+					throw error(message);
+#else
+					(void)message;
+					return detail::job_result<R>::failed();
+#endif // No Exceptions
+				}
+				detail::settop_on_exit restore{ L, base };
+				return detail::job_result<R>::get(L, base + 2);
+			});
+		}
+
+		std::size_t size() const {
+			return workers.size();
+		}
+
+		std::size_t pending_jobs() const {
+			return pending.load();
+		}
+	};
+} // sol
+
+#endif // SOL_STATE_POOL_HPP
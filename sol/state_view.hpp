@@ -26,6 +26,9 @@
 #include "table.hpp"
 #include "environment.hpp"
 #include "load_result.hpp"
+#include "soa.hpp"
+#include "global_watch.hpp"
+#include "observable_table.hpp"
 #include <memory>
 
 namespace sol {
@@ -477,6 +480,17 @@ namespace sol {
 			return *this;
 		}
 
+		template <typename T>
+		global_watch<T> watch_global(std::string name) {
+			return global_watch<T>(L, std::move(name));
+		}
+
+		template<typename Class, typename... Args>
+		state_view& new_soa(Args&&... args) {
+			register_soa<Class>(L, std::forward<Args>(args)...);
+			return *this;
+		}
+
 		template<typename Class, typename... Args>
 		state_view& new_simple_usertype(const std::string& name, Args&&... args) {
 			global.new_simple_usertype<Class>(name, std::forward<Args>(args)...);
@@ -574,6 +588,22 @@ namespace sol {
 			return create_table_with(lua_state(), std::forward<Args>(args)...);
 		}
 
+		observable_table create_observable_table(int narr = 0, int nrec = 0) {
+			return observable_table(lua_state(), narr, nrec);
+		}
+
+		template <typename Name>
+		observable_table create_observable_table(Name&& name, int narr = 0, int nrec = 0) {
+			observable_table x(lua_state(), narr, nrec);
+			global.set(std::forward<Name>(name), x);
+			return x;
+		}
+
+		template <typename Range>
+		table create_table_from(Range&& range) {
+			return create_table_from(lua_state(), std::forward<Range>(range));
+		}
+
 		static inline table create_table(lua_State* L, int narr = 0, int nrec = 0) {
 			return global_table::create(L, narr, nrec);
 		}
@@ -587,6 +617,11 @@ namespace sol {
 		static inline table create_table_with(lua_State* L, Args&&... args) {
 			return global_table::create_with(L, std::forward<Args>(args)...);
 		}
+
+		template <typename Range>
+		static inline table create_table_from(lua_State* L, Range&& range) {
+			return global_table::create_from(L, std::forward<Range>(range));
+		}
 	};
 } // sol
 
@@ -27,6 +27,7 @@
 #include "stack.hpp"
 #include "usertype.hpp"
 #include "table_iterator.hpp"
+#include "stack_proxy.hpp"
 #include "types.hpp"
 
 namespace sol {
@@ -37,6 +38,39 @@ namespace sol {
 		inline int fail_on_newindex(lua_State* L) {
 			return luaL_error(L, "sol: cannot modify the elements of an enumeration table");
 		}
+
+		template <typename K>
+		inline bool is_array_key(std::true_type, const K& key, std::size_t n) {
+			return key >= 1 && static_cast<std::size_t>(key) <= n;
+		}
+
+		template <typename K>
+		inline bool is_array_key(std::false_type, const K&, std::size_t) {
+			return false;
+		}
+
+		template <typename Range>
+		std::pair<int, int> table_size_hints(std::false_type, const Range& range) {
+			using std::begin;
+			using std::end;
+			return std::pair<int, int>(static_cast<int>(std::distance(begin(range), end(range))), 0);
+		}
+
+		template <typename Range>
+		std::pair<int, int> table_size_hints(std::true_type, const Range& range) {
+			typedef meta::unqualified_t<typename meta::unqualified_t<Range>::value_type::first_type> K;
+			typedef meta::all<std::is_integral<K>, meta::neg<std::is_same<K, bool>>> is_integral_key;
+			using std::begin;
+			using std::end;
+			std::size_t n = static_cast<std::size_t>(std::distance(begin(range), end(range)));
+			int narr = 0;
+			for (const auto& kvp : range) {
+				if (is_array_key(is_integral_key(), kvp.first, n)) {
+					++narr;
+				}
+			}
+			return std::pair<int, int>(narr, static_cast<int>(n) - narr);
+		}
 	}
 
 	const new_table create = new_table{};
@@ -75,6 +109,11 @@ namespace sol {
 			}
 		}
 
+		template <typename T>
+		static bool check_traversed(lua_State* L, int index) {
+			return std::is_same<T, stack_proxy>::value || stack::check<T>(L, index);
+		}
+
 		template<typename Ret0, typename Ret1, typename... Ret, std::size_t... I, typename Keys>
 		auto tuple_get(types<Ret0, Ret1, Ret...>, std::index_sequence<0, 1, I...>, Keys&& keys) const
 			-> decltype(stack::pop<std::tuple<Ret0, Ret1, Ret...>>(nullptr)) {
@@ -211,6 +250,10 @@ namespace sol {
 			return iterator();
 		}
 
+		basic_table_pairs<base_type> pairs() const {
+			return basic_table_pairs<base_type>(*this);
+		}
+
 		const_iterator cbegin() const {
 			return begin();
 		}
@@ -356,6 +399,40 @@ namespace sol {
 			for_each(is_paired(), std::forward<Fx>(fx));
 		}
 
+		template<typename K, typename V, typename Fx>
+		void for_each(Fx&& fx) const {
+			lua_State* L = base_t::lua_state();
+			auto pp = stack::push_pop(*this);
+			int tableindex = lua_gettop(L);
+			stack::push(L, lua_nil);
+			while (lua_next(L, tableindex)) {
+				// convert a copy of the key, so string conversions cannot confuse lua_next
+				lua_pushvalue(L, -2);
+				int keyindex = lua_gettop(L);
+				int valueindex = keyindex - 1;
+				if (check_traversed<K>(L, keyindex) && check_traversed<V>(L, valueindex)) {
+					fx(stack::get<K>(L, keyindex), stack::get<V>(L, valueindex));
+				}
+				lua_settop(L, valueindex - 1);
+			}
+		}
+
+		template<typename V, typename Fx>
+		void for_each_array(Fx&& fx) const {
+			lua_State* L = base_t::lua_state();
+			auto pp = stack::push_pop(*this);
+			int tableindex = lua_gettop(L);
+			std::size_t len = static_cast<std::size_t>(lua_rawlen(L, tableindex));
+			for (std::size_t i = 1; i <= len; ++i) {
+				lua_rawgeti(L, tableindex, static_cast<lua_Integer>(i));
+				int valueindex = lua_gettop(L);
+				if (check_traversed<V>(L, valueindex)) {
+					fx(i, stack::get<V>(L, valueindex));
+				}
+				lua_settop(L, tableindex);
+			}
+		}
+
 		size_t size() const {
 			auto pp = stack::push_pop(*this);
 			lua_len(base_t::lua_state(), -1);
@@ -423,6 +500,27 @@ namespace sol {
 			set(std::forward<Key>(key), as_function_reference<function_sig<Sig...>>(std::forward<Args>(args)...));
 		}
 
+		template <typename Range>
+		static void assign_range(std::false_type, lua_State* L, int tableindex, Range&& range) {
+			lua_Integer index = 1;
+			for (auto&& value : range) {
+				stack::raw_set_field(L, index++, value, tableindex);
+			}
+		}
+
+		template <typename Range>
+		static void assign_range(std::true_type, lua_State* L, int tableindex, Range&& range) {
+			for (auto&& kvp : range) {
+				stack::raw_set_field(L, kvp.first, kvp.second, tableindex);
+			}
+		}
+
+		template <typename Range>
+		static void assign_range(lua_State* L, int tableindex, Range&& range) {
+			luaL_checkstack(L, 2, "not enough space left on Lua stack to assign a range to a table");
+			assign_range(meta::has_key_value_pair<meta::unqualified_t<Range>>(), L, tableindex, std::forward<Range>(range));
+		}
+
 	public:
 		static inline table create(lua_State* L, int narr = 0, int nrec = 0) {
 			lua_createtable(L, narr, nrec);
@@ -470,11 +568,33 @@ namespace sol {
 			return x;
 		}
 
+		template <typename Range>
+		static inline table create_from(lua_State* L, Range&& range) {
+			std::pair<int, int> hints = detail::table_size_hints(meta::has_key_value_pair<meta::unqualified_t<Range>>(), range);
+			lua_createtable(L, hints.first, hints.second);
+			table result(L);
+			assign_range(L, lua_gettop(L), std::forward<Range>(range));
+			lua_pop(L, 1);
+			return result;
+		}
+
 		template <typename... Args>
 		table create_with(Args&&... args) {
 			return create_with(base_t::lua_state(), std::forward<Args>(args)...);
 		}
 
+		template <typename Range>
+		table create_from(Range&& range) {
+			return create_from(base_t::lua_state(), std::forward<Range>(range));
+		}
+
+		template <typename Range>
+		basic_table_core& assign(Range&& range) {
+			auto pp = stack::push_pop(*this);
+			assign_range(base_t::lua_state(), lua_gettop(base_t::lua_state()), std::forward<Range>(range));
+			return *this;
+		}
+
 		template <typename Name, typename... Args>
 		table create_named(Name&& name, Args&&... args) {
 			static const int narr = static_cast<int>(meta::count_2_for_pack<std::is_integral, Args...>::value);
@@ -115,6 +115,113 @@ namespace sol {
 		}
 	};
 
+	template <typename reference_type>
+	class basic_table_view_iterator : public std::iterator<std::input_iterator_tag, std::pair<stack_proxy, stack_proxy>> {
+	private:
+		typedef std::iterator<std::input_iterator_tag, std::pair<stack_proxy, stack_proxy>> base_t;
+	public:
+		typedef stack_proxy key_type;
+		typedef stack_proxy mapped_type;
+		typedef base_t::value_type value_type;
+		typedef base_t::iterator_category iterator_category;
+		typedef base_t::difference_type difference_type;
+		typedef base_t::pointer pointer;
+		typedef base_t::reference reference;
+		typedef const value_type& const_reference;
+
+	private:
+		std::pair<stack_proxy, stack_proxy> kvp;
+		reference_type ref;
+		int tableidx = 0;
+		int keyidx = -1;
+		std::ptrdiff_t idx = -1;
+
+	public:
+		basic_table_view_iterator() {
+
+		}
+
+		basic_table_view_iterator(reference_type x) : ref(std::move(x)), idx(0) {
+			ref.push();
+			tableidx = lua_gettop(ref.lua_state());
+			stack::push(ref.lua_state(), lua_nil);
+			keyidx = lua_gettop(ref.lua_state());
+			this->operator++();
+			if (idx == -1) {
+				return;
+			}
+			--idx;
+		}
+
+		basic_table_view_iterator(const basic_table_view_iterator&) = delete;
+		basic_table_view_iterator& operator=(const basic_table_view_iterator&) = delete;
+
+		basic_table_view_iterator(basic_table_view_iterator&& o) : kvp(o.kvp), ref(std::move(o.ref)), tableidx(o.tableidx), keyidx(o.keyidx), idx(o.idx) {
+			o.tableidx = 0;
+			o.keyidx = -1;
+			o.idx = -1;
+		}
+
+		basic_table_view_iterator& operator++() {
+			if (idx == -1)
+				return *this;
+
+			lua_State* L = ref.lua_state();
+			// drop the previous value (and anything left above it), keeping the key for lua_next
+			lua_settop(L, keyidx);
+			if (lua_next(L, tableidx) == 0) {
+				idx = -1;
+				keyidx = -1;
+				return *this;
+			}
+			++idx;
+			keyidx = lua_gettop(L) - 1;
+			kvp.first = stack_proxy(L, keyidx);
+			kvp.second = stack_proxy(L, keyidx + 1);
+			return *this;
+		}
+
+		reference operator*() {
+			return kvp;
+		}
+
+		const_reference operator*() const {
+			return kvp;
+		}
+
+		bool operator== (const basic_table_view_iterator& right) const {
+			return idx == right.idx;
+		}
+
+		bool operator!= (const basic_table_view_iterator& right) const {
+			return idx != right.idx;
+		}
+
+		~basic_table_view_iterator() {
+			if (keyidx != -1) {
+				stack::remove(ref.lua_state(), keyidx, 2);
+			}
+			if (tableidx != 0) {
+				stack::remove(ref.lua_state(), tableidx, 1);
+			}
+		}
+	};
+
+	template <typename reference_type>
+	struct basic_table_pairs {
+		reference_type ref;
+
+		basic_table_pairs(reference_type ref) : ref(std::move(ref)) {}
+
+		basic_table_view_iterator<reference_type> begin() const {
+			return basic_table_view_iterator<reference_type>(ref);
+		}
+
+		basic_table_view_iterator<reference_type> end() const {
+			return basic_table_view_iterator<reference_type>();
+		}
+	};
+
 } // sol
 
 #endif // SOL_TABLE_ITERATOR_HPP
@@ -0,0 +1,167 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_THREAD_POOL_HPP
+#define SOL_THREAD_POOL_HPP
+
+#include "thread.hpp"
+
+namespace sol {
+	namespace detail {
+		inline bool reset_thread(lua_State* co) {
+			// lua_status is LUA_OK for a running thread, and for one that is resuming another, too;
+			// only those have a function on their stack without being suspended
+			lua_Debug ar;
+			if (lua_status(co) == LUA_OK && lua_getstack(co, 0, &ar) != 0) {
+				return false;
+			}
+#if SOL_LUA_VERSION >= 504
+			// closes pending to-be-closed variables and clears errors and yields alike
+			lua_resetthread(co);
+			return true;
+#else
+			// before 5.4, a thread that errored or is still suspended cannot be made resumable again
+			if (lua_status(co) != LUA_OK) {
+				return false;
+			}
+			lua_settop(co, 0);
+			return true;
+#endif // Lua 5.4+ can reset any thread
+		}
+	} // detail
+
+	class thread_pool {
+	private:
+		lua_State* L;
+		reference threads;
+		// the threads handed out by acquire and not yet released, as weak keys
+		reference active;
+		std::size_t limit;
+
+		int push_threads() const {
+			threads.push(L);
+			return lua_gettop(L);
+		}
+
+		// records whether t is checked out, and returns whether it was
+		bool mark_active(const thread& t, bool checked_out) {
+			active.push(L);
+			int activeindex = lua_gettop(L);
+			t.push(L);
+			lua_pushvalue(L, -1);
+			lua_rawget(L, activeindex);
+			bool was = lua_toboolean(L, -1) != 0;
+			lua_pop(L, 1);
+			if (checked_out) {
+				lua_pushboolean(L, 1);
+			}
+			else {
+				lua_pushnil(L);
+			}
+			lua_rawset(L, activeindex);
+			lua_pop(L, 1);
+			return was;
+		}
+
+	public:
+		thread_pool(lua_State* L, std::size_t max_size = 256) : L(L), limit(max_size) {
+			// each pool keeps its threads in its own table, referenced from the registry
+			lua_newtable(L);
+			threads = reference(L, -1);
+			lua_pop(L, 1);
+			lua_newtable(L);
+			lua_createtable(L, 0, 1);
+			lua_pushliteral(L, "k");
+			lua_setfield(L, -2, "__mode");
+			lua_setmetatable(L, -2);
+			active = reference(L, -1);
+			lua_pop(L, 1);
+		}
+
+		thread acquire() {
+			int poolindex = push_threads();
+			std::size_t n = static_cast<std::size_t>(lua_rawlen(L, poolindex));
+			if (n == 0) {
+				lua_newthread(L);
+			}
+			else {
+				lua_rawgeti(L, poolindex, static_cast<lua_Integer>(n));
+				lua_pushnil(L);
+				lua_rawseti(L, poolindex, static_cast<lua_Integer>(n));
+			}
+			thread result(L, -1);
+			lua_settop(L, poolindex - 1);
+			mark_active(result, true);
+			return result;
+		}
+
+		bool release(const thread& t) {
+			if (!t.valid() || t.is_main_thread()) {
+				return false;
+			}
+			lua_State* co = t.thread_state();
+			// a thread that was already released (or never came from this pool) may be in use elsewhere
+			if (!mark_active(t, false)) {
+				return false;
+			}
+			if (!detail::reset_thread(co)) {
+				mark_active(t, true);
+				return false;
+			}
+			int poolindex = push_threads();
+			std::size_t n = static_cast<std::size_t>(lua_rawlen(L, poolindex));
+			bool kept = n < limit;
+			if (kept) {
+				t.push(L);
+				lua_rawseti(L, poolindex, static_cast<lua_Integer>(n + 1));
+			}
+			lua_pop(L, 1);
+			return kept;
+		}
+
+		std::size_t size() const {
+			int poolindex = push_threads();
+			std::size_t n = static_cast<std::size_t>(lua_rawlen(L, poolindex));
+			lua_pop(L, 1);
+			return n;
+		}
+
+		std::size_t max_size() const {
+			return limit;
+		}
+
+		void clear() {
+			int poolindex = push_threads();
+			for (std::size_t n = static_cast<std::size_t>(lua_rawlen(L, poolindex)); n > 0; --n) {
+				lua_pushnil(L);
+				lua_rawseti(L, poolindex, static_cast<lua_Integer>(n));
+			}
+			lua_pop(L, 1);
+		}
+
+		lua_State* lua_state() const {
+			return L;
+		}
+	};
+} // sol
+
+#endif // SOL_THREAD_POOL_HPP
@@ -0,0 +1,269 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_TRANSFER_HPP
+#define SOL_TRANSFER_HPP
+
+#include "stack.hpp"
+#include "object.hpp"
+#include "usertype_traits.hpp"
+#include "error.hpp"
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+namespace sol {
+	namespace detail {
+		typedef void(*transfer_function)(lua_State* from, int index, lua_State* to);
+
+		struct transfer_entry {
+			transfer_function copy;
+		};
+
+		inline const char* transfer_registry() {
+			return "sol.transfer";
+		}
+
+		template <typename T>
+		void transfer_usertype(lua_State* from, int index, lua_State* to) {
+			T* source = stack::get<T*>(from, index);
+			stack::push(to, *source);
+		}
+
+		// maps the metatables of T and T* to entry in the registry table named key, creating it if needed,
+		// and leaves that table on the stack
+		template <typename T>
+		int push_usertype_registry(lua_State* L, const char* key, const void* entry) {
+			lua_getfield(L, LUA_REGISTRYINDEX, key);
+			if (!lua_istable(L, -1)) {
+				lua_pop(L, 1);
+				lua_newtable(L);
+				lua_pushvalue(L, -1);
+				lua_setfield(L, LUA_REGISTRYINDEX, key);
+			}
+			int registryindex = lua_gettop(L);
+			const std::string* names[] = { &usertype_traits<T>::metatable(), &usertype_traits<T*>::metatable() };
+			for (const std::string* name : names) {
+				luaL_getmetatable(L, name->c_str());
+				if (!lua_istable(L, -1)) {
+					lua_pop(L, 1);
+					continue;
+				}
+				lua_pushlightuserdata(L, const_cast<void*>(entry));
+				lua_rawset(L, registryindex);
+			}
+			return registryindex;
+		}
+
+		template <typename T>
+		const transfer_entry* transfer_entry_for() {
+			static const transfer_entry entry{ &transfer_usertype<T> };
+			return &entry;
+		}
+
+		class deep_copier {
+		private:
+			lua_State* from;
+			lua_State* to;
+			int from_cache;
+			int to_cache;
+			int registry;
+			int next_id = 0;
+			std::unordered_map<const void*, int> visited;
+			std::vector<int> pending;
+
+			void fail(int index) {
+#ifndef SOL_NO_EXCEPTIONS
+				throw error(std::string("sol: cannot transfer a value of type ").append(lua_typename(from, lua_type(from, index))));
+#else
+				(void)index;
+				lua_pushnil(to);
+#endif // No Exceptions
+			}
+
+			bool copy_visited(const void* source) {
+				auto it = visited.find(source);
+				if (it == visited.end()) {
+					return false;
+				}
+				lua_rawgeti(to, to_cache, it->second);
+				return true;
+			}
+
+			int remember(const void* source, int index) {
+				int id = ++next_id;
+				visited.emplace(source, id);
+				lua_pushvalue(from, index);
+				lua_rawseti(from, from_cache, id);
+				lua_pushvalue(to, -1);
+				lua_rawseti(to, to_cache, id);
+				return id;
+			}
+
+			void copy_table(int index) {
+				const void* source = lua_topointer(from, index);
+				if (copy_visited(source)) {
+					return;
+				}
+				lua_createtable(to, static_cast<int>(lua_rawlen(from, index)), 0);
+				// the contents are filled in later, so nested tables never recurse
+				pending.push_back(remember(source, index));
+			}
+
+			void copy_userdata(int index) {
+				const void* source = lua_topointer(from, index);
+				if (copy_visited(source)) {
+					return;
+				}
+				const transfer_entry* entry = nullptr;
+				if (registry != 0 && lua_getmetatable(from, index) != 0) {
+					lua_rawget(from, registry);
+					entry = static_cast<const transfer_entry*>(lua_touserdata(from, -1));
+					lua_pop(from, 1);
+				}
+				if (entry == nullptr) {
+					fail(index);
+					return;
+				}
+				entry->copy(from, index, to);
+				remember(source, index);
+			}
+
+			void copy_value(int index) {
+				switch (lua_type(from, index)) {
+				case LUA_TNIL:
+					lua_pushnil(to);
+					break;
+				case LUA_TBOOLEAN:
+					lua_pushboolean(to, lua_toboolean(from, index));
+					break;
+				case LUA_TNUMBER:
+#if SOL_LUA_VERSION >= 503
+					if (lua_isinteger(from, index)) {
+						lua_pushinteger(to, lua_tointeger(from, index));
+						break;
+					}
+#endif // integers keep their subtype
+					lua_pushnumber(to, lua_tonumber(from, index));
+					break;
+				case LUA_TSTRING: {
+					std::size_t len;
+					const char* str = lua_tolstring(from, index, &len);
+					lua_pushlstring(to, str, len);
+					break;
+				}
+				case LUA_TLIGHTUSERDATA:
+					lua_pushlightuserdata(to, lua_touserdata(from, index));
+					break;
+				case LUA_TTABLE:
+					copy_table(index);
+					break;
+				case LUA_TUSERDATA:
+					copy_userdata(index);
+					break;
+				default:
+					fail(index);
+					break;
+				}
+			}
+
+			void fill(int id) {
+				lua_rawgeti(from, from_cache, id);
+				int source = lua_gettop(from);
+				lua_rawgeti(to, to_cache, id);
+				int target = lua_gettop(to);
+				lua_pushnil(from);
+				while (lua_next(from, source) != 0) {
+					int value = lua_gettop(from);
+					copy_value(value - 1);
+					copy_value(value);
+					lua_rawset(to, target);
+					lua_settop(from, value - 1);
+				}
+				lua_settop(to, target - 1);
+				lua_settop(from, source - 1);
+			}
+
+		public:
+			deep_copier(lua_State* from, lua_State* to) : from(from), to(to), from_cache(0), to_cache(0), registry(0) {}
+
+			void run(int index) {
+				index = lua_absindex(from, index);
+				luaL_checkstack(from, 6, "not enough space to transfer a value");
+				luaL_checkstack(to, 6, "not enough space to transfer a value");
+				lua_newtable(from);
+				from_cache = lua_gettop(from);
+				lua_getfield(from, LUA_REGISTRYINDEX, transfer_registry());
+				registry = lua_istable(from, -1) ? lua_gettop(from) : 0;
+				lua_newtable(to);
+				to_cache = lua_gettop(to);
+				copy_value(index);
+				while (!pending.empty()) {
+					int id = pending.back();
+					pending.pop_back();
+					fill(id);
+				}
+			}
+		};
+	} // detail
+
+	template <typename T>
+	void register_transfer(lua_State* L) {
+		detail::push_usertype_registry<T>(L, detail::transfer_registry(), detail::transfer_entry_for<T>());
+		lua_pop(L, 1);
+	}
+
+	inline int transfer(lua_State* from, int index, lua_State* to) {
+		int frombase = lua_gettop(from);
+		int tobase = lua_gettop(to);
+#ifndef SOL_NO_EXCEPTIONS
+		try {
+			detail::deep_copier(from, to).run(index);
+		}
+		catch (...) {
+			lua_settop(from, frombase);
+			lua_settop(to, tobase);
+			throw;
+		}
+#else
+		detail::deep_copier(from, to).run(index);
+#endif // No Exceptions
+		// the copy is on top of the scratch tables: move it down over them
+		// (when both are the same thread, the first scratch table is the one at tobase + 1)
+		if (from != to) {
+			lua_settop(from, frombase);
+		}
+		lua_replace(to, tobase + 1);
+		lua_settop(to, tobase + 1);
+		return 1;
+	}
+
+	inline object transfer(const object& value, lua_State* to) {
+		lua_State* from = value.lua_state();
+		detail::settop_on_exit restore{ from, lua_gettop(from) };
+		value.push();
+		transfer(from, -1, to);
+		return stack::pop<object>(to);
+	}
+} // sol
+
+#endif // SOL_TRANSFER_HPP
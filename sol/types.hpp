@@ -29,6 +29,9 @@
 #include "string_shim.hpp"
 #include <array>
 #include <string>
+#ifdef SOL_STD_STRING_VIEW
+#include <string_view>
+#endif // std::string_view
 
 namespace sol {
 	namespace detail {
@@ -442,6 +445,7 @@ namespace sol {
 		gc = LUA_ERRGCMM,
 		syntax = LUA_ERRSYNTAX,
 		file = LUA_ERRFILE,
+		timeout = -2,
 	};
 
 	enum class thread_status : int {
@@ -481,7 +485,7 @@ namespace sol {
 	};
 
 	inline const std::string& to_string(call_status c) {
-		static const std::array<std::string, 8> names{{
+		static const std::array<std::string, 9> names{{
 			"ok",
 			"yielded",
 			"runtime",
@@ -490,6 +494,7 @@ namespace sol {
 			"gc",
 			"syntax",
 			"file",
+			"timeout",
 		}};
 		switch (c) {
 		case call_status::ok:
@@ -508,6 +513,8 @@ namespace sol {
 			return names[6];
 		case call_status::file:
 			return names[7];
+		case call_status::timeout:
+			return names[8];
 		}
 		return names[0];
 	}
@@ -706,6 +713,7 @@ namespace sol {
 	class coroutine;
 	class thread;
 	struct variadic_args;
+	struct stack_proxy;
 	struct this_state;
 	struct this_environment;
 
@@ -719,6 +727,13 @@ namespace sol {
 		template <>
 		struct lua_type_of<std::wstring> : std::integral_constant<type, type::string> {};
 
+#ifdef SOL_STD_STRING_VIEW
+		// std::string's assignment from anything convertible to a string_view wins over
+		// assigning a converted std::string, so proxies and results have to produce one
+		template <>
+		struct lua_type_of<std::string_view> : std::integral_constant<type, type::string> {};
+#endif // std::string_view
+
 		template <>
 		struct lua_type_of<std::u16string> : std::integral_constant<type, type::string> {};
 
@@ -857,6 +872,9 @@ namespace sol {
 		template <>
 		struct lua_type_of<variadic_args> : std::integral_constant<type, type::poly> {};
 
+		template <>
+		struct lua_type_of<stack_proxy> : std::integral_constant<type, type::poly> {};
+
 		template <>
 		struct lua_type_of<this_state> : std::integral_constant<type, type::poly> {};
 
@@ -881,6 +899,11 @@ namespace sol {
 		template <>
 		struct is_container<std::string> : std::false_type {};
 
+#ifdef SOL_STD_STRING_VIEW
+		template <>
+		struct is_container<std::string_view> : std::false_type {};
+#endif // std::string_view
+
 		template <>
 		struct is_container<std::wstring> : std::false_type {};
 
@@ -934,6 +957,24 @@ namespace sol {
 		struct has_internal_marker : has_internal_marker_impl<T> {};
 	}
 
+	template <typename T>
+	struct struct_fields {};
+
+	namespace detail {
+		template <typename T, typename = void>
+		struct has_struct_fields_impl : std::false_type {};
+		template <typename T>
+		struct has_struct_fields_impl<T, typename void_<decltype(struct_fields<T>::get())>::type> : std::true_type {};
+	}
+
+	template <typename T>
+	struct has_struct_fields : detail::has_struct_fields_impl<T> {};
+
+	namespace detail {
+		template <typename T>
+		struct lua_type_of<T, std::enable_if_t<has_struct_fields<T>::value>> : std::integral_constant<type, type::table> {};
+	}
+
 	template <typename T>
 	struct is_lua_primitive : std::integral_constant<bool,
 		type::userdata != lua_type_of<meta::unqualified_t<T>>::value
@@ -1027,7 +1068,10 @@ namespace sol {
 
 	template <typename T>
 	struct is_container : detail::is_container<T>{};
-	
+
+	template <typename T>
+	struct is_proxied_container : std::false_type {};
+
 	template<typename T>
 	inline type type_of() {
 		return lua_type_of<meta::unqualified_t<T>>::value;
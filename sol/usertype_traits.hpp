@@ -54,6 +54,9 @@ namespace sol {
 		}
 	};
 
+	template <typename T>
+	struct usertype_serializer {};
+
 }
 
 #endif // SOL_USERTYPE_TRAITS_HPP
@@ -0,0 +1,202 @@
+// The MIT License (MIT) 
+
+// Copyright (c) 2013-2017 Rapptz, ThePhD and contributors
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef SOL_YIELDING_HPP
+#define SOL_YIELDING_HPP
+
+#include "stack.hpp"
+#include "function_types.hpp"
+#include <future>
+#include <chrono>
+#include <memory>
+#include <utility>
+
+namespace sol {
+
+	template <typename T>
+	struct awaitable_traits {};
+
+	template <typename T>
+	struct awaitable_traits<std::future<T>> {
+		static bool ready(const std::future<T>& value) {
+			return value.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+		}
+
+		static decltype(auto) get(std::future<T>& value) {
+			return value.get();
+		}
+	};
+
+	template <typename T>
+	struct awaitable_traits<std::shared_future<T>> {
+		static bool ready(const std::shared_future<T>& value) {
+			return value.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+		}
+
+		static decltype(auto) get(std::shared_future<T>& value) {
+			return value.get();
+		}
+	};
+
+	namespace detail {
+		template <typename T, typename = void>
+		struct is_awaitable_impl : std::false_type {};
+
+		template <typename T>
+		struct is_awaitable_impl<T, typename void_<decltype(awaitable_traits<T>::ready(std::declval<T&>()))>::type> : std::true_type {};
+
+		struct pending_await {
+			virtual ~pending_await() {}
+			virtual bool ready() = 0;
+			virtual int push(lua_State* L) = 0;
+		};
+
+		template <typename A>
+		struct pending_await_of : pending_await {
+			typedef awaitable_traits<A> traits;
+			A value;
+
+			pending_await_of(A&& value) : value(std::move(value)) {}
+
+			bool ready() override {
+				return traits::ready(value);
+			}
+
+			int push(lua_State* L) override {
+				return push_result(L, std::is_void<decltype(traits::get(value))>());
+			}
+
+		private:
+			int push_result(lua_State*, std::true_type) {
+				traits::get(value);
+				return 0;
+			}
+
+			int push_result(lua_State* L, std::false_type) {
+				return stack::push(L, traits::get(value));
+			}
+		};
+
+		inline const char* pending_await_metatable() {
+			return "sol.pending_await";
+		}
+
+		inline int pending_await_gc(lua_State* L) {
+			pending_await** data = static_cast<pending_await**>(lua_touserdata(L, 1));
+			delete *data;
+			*data = nullptr;
+			return 0;
+		}
+
+		inline bool is_pending_await(lua_State* L, int index) {
+			return luaL_testudata(L, index, pending_await_metatable()) != nullptr;
+		}
+
+		inline std::unique_ptr<pending_await> take_pending_await(lua_State* L, int index) {
+			pending_await** data = static_cast<pending_await**>(lua_touserdata(L, index));
+			std::unique_ptr<pending_await> taken(*data);
+			*data = nullptr;
+			return taken;
+		}
+
+		inline int yield_results(lua_State* L) {
+			int nargs = lua_gettop(L);
+			lua_pushvalue(L, lua_upvalueindex(1));
+			lua_insert(L, 1);
+			lua_call(L, nargs, LUA_MULTRET);
+			// no continuation is needed: whatever the coroutine is resumed with becomes the results of the call
+			return lua_yield(L, lua_gettop(L));
+		}
+	} // detail
+
+	template <typename T>
+	struct is_awaitable : detail::is_awaitable_impl<meta::unqualified_t<T>> {};
+
+	template <typename F>
+	struct yielding_t {
+		F func;
+
+		template <typename... Args>
+		yielding_t(Args&&... args) : func(std::forward<Args>(args)...) {}
+	};
+
+	template <typename F>
+	auto yielding(F&& f) {
+		return yielding_t<std::decay_t<F>>(std::forward<F>(f));
+	}
+
+	template <typename A>
+	struct awaitable_t {
+		A value;
+
+		awaitable_t(A value) : value(std::move(value)) {}
+	};
+
+	// opts a future (or anything with awaitable_traits) in to being pushed as a handle a scheduler can wait on;
+	// without it, the value is pushed like any other C++ type
+	template <typename A>
+	auto awaitable(A&& value) {
+		static_assert(is_awaitable<A>::value, "sol::awaitable needs a type with a specialization of sol::awaitable_traits");
+		return awaitable_t<std::decay_t<A>>(std::forward<A>(value));
+	}
+
+	namespace stack {
+		template <typename A>
+		struct pusher<awaitable_t<A>> {
+			typedef A awaitable_type;
+
+			static int push(lua_State* L, awaitable_t<A>&& a) {
+				return push_value(L, std::move(a.value));
+			}
+
+			static int push(lua_State* L, const awaitable_t<A>& a) {
+				awaitable_type copy(a.value);
+				return push_value(L, std::move(copy));
+			}
+
+		private:
+			static int push_value(lua_State* L, awaitable_type&& value) {
+				detail::pending_await** data = static_cast<detail::pending_await**>(lua_newuserdata(L, sizeof(detail::pending_await*)));
+				*data = nullptr;
+				if (luaL_newmetatable(L, detail::pending_await_metatable()) == 1) {
+					lua_pushcfunction(L, &detail::pending_await_gc);
+					lua_setfield(L, -2, "__gc");
+				}
+				lua_setmetatable(L, -2);
+				*data = new detail::pending_await_of<awaitable_type>(std::move(value));
+				return 1;
+			}
+		};
+
+		template <typename F>
+		struct pusher<yielding_t<F>> {
+			template <typename Y>
+			static int push(lua_State* L, Y&& y) {
+				pusher<function_sig<>>{}.push(L, std::forward<Y>(y).func);
+				lua_pushcclosure(L, &detail::yield_results, 1);
+				return 1;
+			}
+		};
+	} // stack
+} // sol
+
+#endif // SOL_YIELDING_HPP
@@ -0,0 +1 @@
+bad.code = 20
\ No newline at end of file
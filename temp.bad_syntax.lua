@@ -0,0 +1,3 @@
+weird
+%$@symb
+ols
\ No newline at end of file
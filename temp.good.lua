@@ -0,0 +1,2 @@
+a = 21
+return a
\ No newline at end of file
@@ -821,3 +821,195 @@ TEST_CASE("containers/pairs", "test how well pairs work with the underlying syst
 	//REQUIRE(dv1 == 1);
 	//REQUIRE(dv2 == sol::lua_nil);
 }
+
+struct proxied_entity {
+	int x;
+	proxied_entity(int x) : x(x) {}
+};
+
+namespace sol {
+	template <>
+	struct is_proxied_container<std::vector<proxied_entity>> : std::true_type {};
+}
+
+TEST_CASE("containers/proxied-elements", "elements of a proxied container are handed out through one reusable userdata per index") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.new_usertype<proxied_entity>("proxied_entity",
+		"x", &proxied_entity::x
+	);
+	std::vector<proxied_entity> entities{ 1, 2, 3 };
+	lua["c"] = &entities;
+
+	lua.script(R"(
+a = c[1]
+b = c[1]
+same = rawequal(a, b)
+c[2].x = 20
+total = 0
+for i, e in pairs(c) do
+	total = total + e.x
+end
+)");
+	bool same = lua["same"];
+	int total = lua["total"];
+	REQUIRE(same);
+	REQUIRE(entities[1].x == 20);
+	REQUIRE(total == 24);
+
+	entities.reserve(entities.capacity() * 4);
+	entities.emplace_back(4);
+	lua.script("c[1].x = 10 last = c[4].x");
+	int last = lua["last"];
+	REQUIRE(entities[0].x == 10);
+	REQUIRE(last == 4);
+}
+
+TEST_CASE("containers/numeric-buffers", "contiguous arithmetic containers and sol::buffer expose bulk kernels without copying into tables") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+
+	std::vector<float> samples{ 1.f, 2.f, 3.f, 4.f, 5.f };
+	std::vector<float> gains{ 2.f, 2.f, 2.f, 2.f, 2.f };
+	int raw[6] = { 3, -1, 4, 1, -5, 9 };
+	lua["samples"] = &samples;
+	lua["gains"] = &gains;
+	lua["raw"] = sol::make_buffer(raw);
+
+	lua.script(R"(
+s = samples:sum()
+d = samples:dot(gains)
+lo = raw:min()
+hi = raw:max()
+rawsum = raw:sum()
+samples:scale(2)
+samples:accumulate(gains, 0.5)
+raw[2] = 10
+gains:fill(0)
+n = #raw
+)");
+	float s = lua["s"];
+	float d = lua["d"];
+	int lo = lua["lo"];
+	int hi = lua["hi"];
+	int rawsum = lua["rawsum"];
+	std::size_t n = lua["n"];
+	REQUIRE(s == 15.f);
+	REQUIRE(d == 30.f);
+	REQUIRE(lo == -5);
+	REQUIRE(hi == 9);
+	REQUIRE(rawsum == 11);
+	REQUIRE(n == 6);
+	REQUIRE(samples[0] == 3.f);
+	REQUIRE(samples[4] == 11.f);
+	REQUIRE(raw[1] == 10);
+	REQUIRE(gains[3] == 0.f);
+
+	REQUIRE_THROWS([&]() {
+		lua.script("raw[7] = 1");
+	}());
+	REQUIRE_THROWS([&]() {
+		lua.script("samples:dot(raw)");
+	}());
+
+	float weights[3] = { 1.f, 2.f, 3.f };
+	std::vector<float> ones{ 1.f, 1.f, 1.f };
+	lua["weights"] = sol::make_buffer(weights);
+	lua["ones"] = &ones;
+	lua.script(R"(
+wd = weights:dot(ones)
+ones:accumulate(weights, 2)
+)");
+	float wd = lua["wd"];
+	REQUIRE(wd == 6.f);
+	REQUIRE(ones[0] == 3.f);
+	REQUIRE(ones[2] == 7.f);
+	REQUIRE_THROWS([&]() {
+		lua.script("weights:dot(samples)");
+	}());
+}
+
+struct soa_particles {
+	std::vector<float> x, y, vx, vy;
+};
+
+TEST_CASE("containers/soa", "struct-of-arrays stores expose rows as reusable handles and columns as buffers") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.new_soa<soa_particles>(
+		"x", &soa_particles::x,
+		"y", &soa_particles::y,
+		"vx", &soa_particles::vx,
+		"vy", &soa_particles::vy
+	);
+
+	soa_particles p;
+	p.x = { 0.f, 1.f, 2.f };
+	p.y = { 0.f, 0.f, 0.f };
+	p.vx = { 1.f, 1.f, 1.f };
+	p.vy = { 2.f, 4.f, 8.f };
+	lua["p"] = &p;
+
+	lua.script(R"(
+n = #p
+same = rawequal(p[2], p[2])
+p[1].y = 5
+p.x:accumulate(p.vx, 0.5)
+p.y:accumulate(p.vy, 0.5)
+third_x = p[3].x
+missing = p[4]
+)");
+	std::size_t n = lua["n"];
+	bool same = lua["same"];
+	float third_x = lua["third_x"];
+	sol::object missing = lua["missing"];
+	REQUIRE(n == 3);
+	REQUIRE(same);
+	REQUIRE(third_x == 2.5f);
+	REQUIRE(missing == sol::nil);
+	REQUIRE(p.x[0] == 0.5f);
+	REQUIRE(p.y[0] == 6.f);
+	REQUIRE(p.y[2] == 4.f);
+
+	REQUIRE_THROWS([&]() {
+		lua.script("p[1].z = 2");
+	}());
+
+	lua.script("h = p[3]");
+	p.x.resize(2);
+	p.y.resize(2);
+	std::size_t shrunk = lua.script("return #p");
+	sol::object gone = lua.script("return p[3]");
+	REQUIRE(shrunk == 2);
+	REQUIRE(gone == sol::nil);
+	REQUIRE_THROWS([&]() {
+		lua.script("h.x = 42");
+	}());
+	REQUIRE_THROWS([&]() {
+		lua.script("return h.y");
+	}());
+	float vy = lua.script("return h.vy");
+	REQUIRE(vy == 8.f);
+}
+
+TEST_CASE("containers/nested-presized", "nested and associative table conversions read raw values into pre-sized containers") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.script(R"(
+cfg = {
+	groups = {
+		a = { 1, 2, 3 },
+		b = { 4, 5 },
+		c = {},
+	},
+	list = setmetatable({ 10, 20 }, { __index = function(t, k) return 99 end }),
+}
+)");
+	std::unordered_map<std::string, std::vector<int>> groups = lua["cfg"]["groups"].get<sol::nested<std::unordered_map<std::string, std::vector<int>>>>();
+	std::vector<int> list = lua["cfg"]["list"].get<sol::as_table_t<std::vector<int>>>();
+	REQUIRE(groups.size() == 3);
+	REQUIRE(groups["a"] == std::vector<int>{ 1, 2, 3 });
+	REQUIRE(groups["b"] == std::vector<int>{ 4, 5 });
+	REQUIRE(groups["c"].empty());
+	REQUIRE(list == std::vector<int>{ 10, 20 });
+}
@@ -3,6 +3,57 @@
 #include <catch.hpp>
 #include <sol.hpp>
 
+#if defined(SOL_TESTS_CXX20_COROUTINES) && !defined(SOL_CXX20_COROUTINES)
+#error "this build is meant to run the co_await tests, but SOL_CXX20_COROUTINES is not defined"
+#endif // CI builds that must not skip the C++20 tests
+
+#ifdef SOL_CXX20_COROUTINES
+struct detached_task {
+	struct promise_type {
+		detached_task get_return_object() {
+			return{};
+		}
+		std::suspend_never initial_suspend() noexcept {
+			return{};
+		}
+		std::suspend_never final_suspend() noexcept {
+			return{};
+		}
+		void return_void() {}
+		void unhandled_exception() {
+			std::terminate();
+		}
+	};
+};
+
+detached_task step_through(sol::coroutine& co, std::vector<int>& seen) {
+	while (co.runnable()) {
+		sol::protected_function_result r = co_await sol::resume(co, 2);
+		int value = r;
+		seen.push_back(value);
+	}
+}
+
+detached_task resume_later(sol::coroutine& co, std::vector<int>& seen) {
+	// the argument is a temporary that is gone before the awaiter is awaited
+	auto pending = sol::resume(co, std::string("5"));
+	sol::protected_function_result r = co_await pending;
+	int value = r;
+	seen.push_back(value);
+}
+
+detached_task join_task(sol::scheduler& sched, sol::task_id id, std::vector<int>& seen) {
+	sol::task_result result = co_await sol::join(sched, id);
+	REQUIRE(result.valid());
+	seen.push_back(result.values[0].as<int>());
+	result = co_await sol::join(sched, id);
+	REQUIRE(result.unknown);
+	REQUIRE_FALSE(result.cancelled);
+	REQUIRE_FALSE(result.valid());
+	seen.push_back(-1);
+}
+#endif // C++20 coroutines
+
 TEST_CASE("threading/coroutines", "ensure calling a coroutine works") {
 	const auto& script = R"(counter = 20
  
@@ -61,4 +112,429 @@ end
 	}
 	counter -= 1;
 	REQUIRE(counter == 30);
-}
\ No newline at end of file
+}
+TEST_CASE("threading/thread_pool", "finished threads are reset and handed out again instead of allocating new ones") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::coroutine);
+	lua.script(R"(
+function task(x)
+	coroutine.yield(x)
+	return x * 2
+end
+function fails()
+	error("nope")
+end
+)");
+	sol::thread_pool pool(lua, 2);
+	REQUIRE(pool.size() == 0);
+
+	sol::thread runner = pool.acquire();
+	lua_State* first = runner.thread_state();
+	for (int i = 0; i < 3; ++i) {
+		sol::thread t = i == 0 ? runner : pool.acquire();
+		REQUIRE(t.thread_state() == first);
+		sol::coroutine co = t.state()["task"];
+		int yielded = co(i);
+		REQUIRE(yielded == i);
+		int finished = co();
+		REQUIRE(finished == i * 2);
+		REQUIRE(co.status() == sol::call_status::ok);
+		REQUIRE(pool.release(t));
+		REQUIRE(pool.size() == 1);
+	}
+
+	REQUIRE_FALSE(pool.release(runner));
+	REQUIRE(pool.size() == 1);
+
+	// a thread that is running, or is resuming another coroutine, must not be reset under itself
+	sol::thread busy = pool.acquire();
+	lua["give_back"] = [&pool, &busy]() { return pool.release(busy); };
+	lua.script(R"(
+function direct()
+	return give_back()
+end
+function nested()
+	local inner = coroutine.create(function() return give_back() end)
+	local ok, released = coroutine.resume(inner)
+	return released
+end
+)");
+	sol::coroutine direct = busy.state()["direct"];
+	bool released = direct();
+	REQUIRE_FALSE(released);
+	sol::coroutine nested = busy.state()["nested"];
+	released = nested();
+	REQUIRE_FALSE(released);
+	REQUIRE(pool.release(busy));
+	REQUIRE(pool.size() == 1);
+
+	sol::thread suspended = pool.acquire();
+	sol::coroutine co = suspended.state()["task"];
+	int yielded = co(5);
+	REQUIRE(yielded == 5);
+#if SOL_LUA_VERSION >= 504
+	REQUIRE(pool.release(suspended));
+#else
+	REQUIRE_FALSE(pool.release(suspended));
+#endif
+	sol::thread mainthread(lua, lua.lua_state());
+	REQUIRE_FALSE(pool.release(mainthread));
+
+	pool.clear();
+	REQUIRE(pool.size() == 0);
+	REQUIRE(pool.release(pool.acquire()));
+	REQUIRE(pool.release(pool.acquire()));
+	sol::thread a = pool.acquire();
+	sol::thread b = pool.acquire();
+	sol::thread c = pool.acquire();
+	REQUIRE(pool.release(a));
+	REQUIRE(pool.release(b));
+	REQUIRE_FALSE(pool.release(c));
+	REQUIRE(pool.size() == 2);
+
+	sol::thread_pool other(lua, 1);
+	REQUIRE(other.size() == 0);
+	REQUIRE(other.release(other.acquire()));
+	REQUIRE_FALSE(other.release(sol::thread::create(lua)));
+	REQUIRE(other.size() == 1);
+	pool.clear();
+	REQUIRE(pool.size() == 0);
+	REQUIRE(other.size() == 1);
+}
+
+TEST_CASE("threading/scheduler", "the scheduler runs tasks, timers and signals within a tick budget") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::coroutine);
+	sol::scheduler sched(lua);
+	lua.script(R"(
+log = {}
+function sleeper(name, t)
+	scheduler.wait(t)
+	log[#log + 1] = name
+end
+function listener()
+	local a, b = scheduler.wait_signal("door")
+	log[#log + 1] = "door:" .. a .. b
+end
+function broken()
+	error("boom")
+end
+function counter(n)
+	for i = 1, n do
+		coroutine.yield()
+	end
+	log[#log + 1] = "counted"
+end
+)");
+	sched.spawn(lua["sleeper"], "late", 2.0);
+	sched.spawn(lua["sleeper"], "early", 1.0);
+	sched.spawn(lua["listener"]);
+	sol::task_id c = sched.spawn(lua["counter"], 3);
+	REQUIRE(sched.size() == 4);
+
+	REQUIRE(sched.tick(0) == 4);
+	REQUIRE(sched.tick(0.5) == 1);
+	REQUIRE(sched.alive(c));
+	REQUIRE(sched.signal("door", 1, "x") == 1);
+	sched.tick(0.6);
+	sched.tick(1.0);
+	sched.tick(0);
+	REQUIRE_FALSE(sched.alive(c));
+	REQUIRE(sched.empty());
+	sol::table log = lua["log"];
+	REQUIRE(log.get<std::string>(1) == "door:1x");
+	REQUIRE(log.get<std::string>(2) == "early");
+	REQUIRE(log.get<std::string>(3) == "counted");
+	REQUIRE(log.get<std::string>(4) == "late");
+
+	lua.script("for i = 1, 10 do scheduler.spawn(function() coroutine.yield() end) end");
+	sched.set_max_resumes(4);
+	REQUIRE(sched.tick() == 4);
+	REQUIRE(sched.tick() == 4);
+	REQUIRE(sched.tick() == 4);
+	sched.set_max_resumes(0);
+	while (!sched.empty()) {
+		sched.tick();
+	}
+
+	sol::task_id waiting = sched.spawn(lua["listener"]);
+	sched.tick();
+	REQUIRE(sched.cancel(waiting));
+	REQUIRE(sched.signal("door", 1, 2) == 0);
+	sol::task_id rewaiting = sched.spawn(lua["listener"]);
+	sched.tick();
+	REQUIRE(sched.cancel(rewaiting));
+	sol::task_id listening = sched.spawn(lua["listener"]);
+	sched.tick();
+	REQUIRE(sched.signal("door", 1, 2) == 1);
+	sched.tick();
+	REQUIRE_FALSE(sched.alive(listening));
+
+	sched.spawn(lua["broken"]);
+	REQUIRE_THROWS(sched.tick());
+	std::string lasterror;
+	sched.set_error_handler([&](sol::task_id, const std::string& message) { lasterror = message; });
+	sched.spawn(lua["broken"]);
+	sched.tick();
+	REQUIRE_FALSE(lasterror.empty());
+	REQUIRE_THROWS(lua.script("scheduler.wait(1)"));
+
+	{
+		sol::scheduler inner(lua, "inner");
+		lua.script("kept = inner");
+	}
+	sol::protected_function_result afterwards = lua.do_string("kept.spawn(function() end)");
+	REQUIRE_FALSE(afterwards.valid());
+}
+
+TEST_CASE("threading/execution_limit", "runaway scripts are stopped by instruction and time budgets") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::coroutine);
+	lua.script(R"(
+function spin()
+	while true do end
+end
+function count(n)
+	local total = 0
+	for i = 1, n do total = total + i end
+	return total
+end
+function long_sum(n)
+	local total = 0
+	for i = 1, n do total = total + 1 end
+	return total
+end
+function caught()
+	while true do pcall(function() while true do end end) end
+end
+function wrapped()
+	coroutine.wrap(function() while true do end end)()
+end
+)");
+	sol::protected_function spin = lua["spin"];
+	spin.limit = sol::execution_limit(100000);
+	sol::protected_function_result r = spin();
+	REQUIRE_FALSE(r.valid());
+	REQUIRE(r.status() == sol::call_status::timeout);
+
+	spin.limit = sol::execution_limit(std::chrono::milliseconds(20));
+	r = spin();
+	REQUIRE(r.status() == sol::call_status::timeout);
+
+	sol::protected_function caught = lua["caught"];
+	caught.limit = sol::execution_limit(std::chrono::milliseconds(50));
+	r = caught();
+	REQUIRE(r.status() == sol::call_status::timeout);
+	sol::protected_function wrapped = lua["wrapped"];
+	wrapped.limit = sol::execution_limit(std::chrono::milliseconds(50));
+	r = wrapped();
+	REQUIRE(r.status() == sol::call_status::timeout);
+	REQUIRE(lua_gethook(lua) == nullptr);
+
+	sol::protected_function count = lua["count"];
+	count.limit = sol::execution_limit(100000);
+	int total = count(10);
+	REQUIRE(total == 55);
+	REQUIRE(lua_gethook(lua) == nullptr);
+
+	sol::thread runner = sol::thread::create(lua);
+	sol::coroutine co = runner.state()["long_sum"];
+	co.limit = sol::execution_limit(10000);
+	auto first = co(100000);
+#if SOL_LUA_VERSION >= 502
+	REQUIRE(co.status() == sol::call_status::timeout);
+	REQUIRE(co.runnable());
+	REQUIRE_FALSE(co.error());
+	std::size_t resumes = 1;
+	while (co.runnable()) {
+		auto next = co();
+		++resumes;
+		if (co.status() == sol::call_status::ok) {
+			int sum = next;
+			REQUIRE(sum == 100000);
+		}
+	}
+	REQUIRE(resumes > 2);
+	REQUIRE(co.status() == sol::call_status::ok);
+
+	sol::scheduler sched(lua);
+	sched.set_execution_limit(sol::execution_limit(10000));
+	sched.spawn(lua["long_sum"], 100000);
+	std::size_t ticks = 0;
+	while (!sched.empty()) {
+		sched.tick();
+		++ticks;
+	}
+	REQUIRE(ticks > 2);
+#else
+	REQUIRE(co.status() == sol::call_status::timeout);
+	REQUIRE(co.error());
+#endif
+}
+
+TEST_CASE("threading/yielding", "yielding C++ functions suspend the calling coroutine until what they returned is ready") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::coroutine);
+
+	lua["pause"] = sol::yielding([](int x) { return x * 2; });
+	lua.script(R"(
+function paused(x)
+	local resumed = pause(x)
+	return resumed + 1
+end
+)");
+	sol::thread runner = sol::thread::create(lua);
+	sol::coroutine co = runner.state()["paused"];
+	int yielded = co(21);
+	REQUIRE(yielded == 42);
+	REQUIRE(co.runnable());
+	int finished = co(9);
+	REQUIRE(finished == 10);
+	REQUIRE_FALSE(co.runnable());
+
+	std::vector<std::promise<int>> requests;
+	requests.reserve(8);
+	lua["fetch"] = sol::yielding([&requests](int) {
+		requests.emplace_back();
+		return sol::awaitable(requests.back().get_future());
+	});
+	lua["start"] = [&requests]() {
+		requests.emplace_back();
+		return sol::awaitable(requests.back().get_future());
+	};
+	lua["fail"] = sol::yielding([]() {
+		std::promise<void> p;
+		p.set_exception(std::make_exception_ptr(std::runtime_error("refused")));
+		return sol::awaitable(p.get_future());
+	});
+	// without sol::awaitable, a future is pushed as an ordinary usertype
+	lua.new_usertype<std::future<int>>("int_future", "valid", &std::future<int>::valid);
+	lua["plain"] = []() {
+		std::promise<int> p;
+		p.set_value(5);
+		return p.get_future();
+	};
+	lua.script(R"(
+results = {}
+function connection(id)
+	local value = fetch(id)
+	results[id] = value
+end
+function both()
+	local a = start()
+	local b = start()
+	results.both = scheduler.await(a) + scheduler.await(b)
+end
+)");
+	sol::scheduler sched(lua);
+	sched.spawn(lua["connection"], 1);
+	sched.spawn(lua["connection"], 2);
+	REQUIRE(sched.tick() == 2);
+	REQUIRE(requests.size() == 2);
+	REQUIRE(sched.tick() == 0);
+
+	requests[1].set_value(20);
+	REQUIRE(sched.tick() == 1);
+	sol::table results = lua["results"];
+	REQUIRE(results.get<int>(2) == 20);
+	REQUIRE(sched.size() == 1);
+	requests[0].set_value(10);
+	sched.tick();
+	REQUIRE(results.get<int>(1) == 10);
+	REQUIRE(sched.empty());
+
+	sched.spawn(lua["both"]);
+	sched.tick();
+	requests[3].set_value(2);
+	REQUIRE(sched.tick() == 0);
+	requests[2].set_value(1);
+	sched.tick();
+	sched.tick();
+	REQUIRE(results.get<int>("both") == 3);
+	REQUIRE(sched.empty());
+
+	sol::task_id cancelled = sched.spawn(lua["connection"], 3);
+	sched.tick();
+	REQUIRE(sched.cancel(cancelled));
+	requests[4].set_value(30);
+	REQUIRE(sched.tick() == 0);
+
+	std::string lasterror;
+	sched.set_error_handler([&](sol::task_id, const std::string& message) { lasterror = message; });
+	sched.spawn(lua["fail"]);
+	sched.tick();
+	sched.tick();
+	REQUIRE(lasterror == "refused");
+	REQUIRE(sched.empty());
+
+	REQUIRE(lua.script("return plain():valid()").get<bool>());
+	lua.script("function plain_await() return scheduler.await(plain()) end");
+	sched.spawn(lua["plain_await"]);
+	sched.tick();
+	REQUIRE(lasterror.find("awaitable") != std::string::npos);
+	REQUIRE(sched.empty());
+}
+
+TEST_CASE("threading/task_results", "the values a scheduled task returns or fails with are handed to whoever waits on it") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::coroutine);
+	sol::scheduler sched(lua);
+	lua.script(R"(
+function compute(a, b)
+	coroutine.yield()
+	return a + b, "done"
+end
+function broken()
+	coroutine.yield()
+	error("boom")
+end
+function forever()
+	while true do coroutine.yield() end
+end
+)");
+	std::vector<sol::task_result> finished;
+	auto keep = [&finished](const sol::task_result& r) { finished.push_back(r); };
+	sol::task_id sum = sched.spawn(lua["compute"], 1, 2);
+	sol::task_id bad = sched.spawn(lua["broken"]);
+	sol::task_id endless = sched.spawn(lua["forever"]);
+	REQUIRE(sched.on_finish(sum, keep));
+	REQUIRE(sched.on_finish(bad, keep));
+	REQUIRE(sched.on_finish(endless, keep));
+	sched.tick();
+	REQUIRE(finished.empty());
+	sched.tick();
+	REQUIRE(finished.size() == 2);
+	REQUIRE(finished[0].valid());
+	REQUIRE(finished[0].values.size() == 2);
+	REQUIRE(finished[0].values[0].as<int>() == 3);
+	REQUIRE(finished[0].values[1].as<std::string>() == "done");
+	REQUIRE_FALSE(finished[1].valid());
+	REQUIRE(finished[1].status == sol::call_status::runtime);
+	REQUIRE(sched.cancel(endless));
+	REQUIRE(finished.size() == 3);
+	REQUIRE(finished[2].cancelled);
+	REQUIRE_FALSE(sched.on_finish(sum, keep));
+
+#ifdef SOL_CXX20_COROUTINES
+	std::vector<int> seen;
+	lua.script("function steps(n) for i = 1, 3 do n = coroutine.yield(n * i) end return 0 end");
+	sol::thread runner = sol::thread::create(lua);
+	sol::coroutine co = runner.state()["steps"];
+	step_through(co, seen);
+	REQUIRE(seen == std::vector<int>{ 2, 4, 6, 0 });
+
+	seen.clear();
+	sol::thread later_runner = sol::thread::create(lua);
+	sol::coroutine later = later_runner.state()["steps"];
+	resume_later(later, seen);
+	REQUIRE(seen == std::vector<int>{ 5 });
+
+	seen.clear();
+	sol::task_id joined = sched.spawn(lua["compute"], 20, 22);
+	join_task(sched, joined, seen);
+	REQUIRE(seen.empty());
+	sched.tick();
+	sched.tick();
+	REQUIRE(seen == std::vector<int>{ 42, -1 });
+#endif // C++20 coroutines
+}
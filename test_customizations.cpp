@@ -84,3 +84,183 @@ TEST_CASE("customization/split-struct", "using the newly documented customizatio
 	REQUIRE_FALSE(thingsg.b);
 	REQUIRE(d == 36.5);
 }
+
+struct window_config {
+	int width = 0;
+	int height = 0;
+	std::string title;
+	bool vsync = false;
+};
+
+struct app_config {
+	window_config window;
+	double volume = 1.0;
+};
+
+namespace sol {
+	template <>
+	struct struct_fields<window_config> {
+		static auto get() {
+			return sol::fields("width", &window_config::width, "height", &window_config::height, "title", &window_config::title, "vsync", &window_config::vsync);
+		}
+	};
+
+	template <>
+	struct struct_fields<app_config> {
+		static auto get() {
+			return sol::fields("window", &app_config::window, "volume", &app_config::volume);
+		}
+	};
+}
+
+TEST_CASE("customization/struct_fields", "structs with declared fields round-trip through plain tables") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+
+	app_config cfg;
+	cfg.window.width = 1280;
+	cfg.window.height = 720;
+	cfg.window.title = "game";
+	cfg.volume = 0.25;
+	lua["cfg"] = cfg;
+	lua.script("assert(type(cfg) == 'table') assert(cfg.window.width == 1280) assert(cfg.window.title == 'game') assert(cfg.volume == 0.25)");
+
+	lua.script("cfg.window.vsync = true cfg.window.height = 1080 other = { window = { width = 640 } }");
+	app_config back = lua["cfg"];
+	REQUIRE(back.window.width == 1280);
+	REQUIRE(back.window.height == 1080);
+	REQUIRE(back.window.vsync);
+	REQUIRE(back.volume == 0.25);
+
+	app_config other = lua["other"];
+	REQUIRE(other.window.width == 640);
+	REQUIRE(other.window.title.empty());
+	REQUIRE(other.volume == 1.0);
+
+	lua.script("bad = { window = 5 } notatable = 5");
+	sol::object bad = lua["bad"];
+	REQUIRE_FALSE(bad.is<app_config>());
+	REQUIRE_FALSE(lua["notatable"].get<sol::optional<app_config>>());
+	lua.set_function("volume_of", [](const app_config& c) { return c.volume; });
+	sol::protected_function_result rejected = lua.do_string("return volume_of(bad)");
+	REQUIRE_FALSE(rejected.valid());
+
+	lua.set_function("area", [](const window_config& w) { return w.width * w.height; });
+	int area = lua.script("return area({ width = 3, height = 4 })");
+	REQUIRE(area == 12);
+}
+
+TEST_CASE("customization/lazy_view", "lazy views convert only the fields a script reads") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+
+	app_config cfg;
+	cfg.window.width = 1280;
+	cfg.window.title = "game";
+	cfg.volume = 0.5;
+	lua.script("function handler(e) return e.window.width, e.window.title, e.volume, e.missing end");
+	sol::function handler = lua["handler"];
+	std::tuple<int, std::string, double, sol::object> result = handler(sol::make_lazy_view(cfg));
+	REQUIRE(std::get<0>(result) == 1280);
+	REQUIRE(std::get<1>(result) == "game");
+	REQUIRE(std::get<2>(result) == 0.5);
+	REQUIRE_FALSE(std::get<3>(result).valid());
+
+	cfg.volume = 0.75;
+	lua["view"] = sol::lazy_view<app_config>(cfg);
+	double volume = lua.script("return view.volume");
+	REQUIRE(volume == 0.75);
+	REQUIRE_THROWS(lua.script("view.volume = 2"));
+}
+
+struct snapshot_vec {
+	float x, y, z;
+};
+
+struct snapshot_player {
+	std::string name;
+	int level;
+};
+
+namespace sol {
+	template <>
+	struct usertype_serializer<snapshot_vec> : trivial_usertype_serializer<snapshot_vec> {};
+
+	template <>
+	struct usertype_serializer<snapshot_player> {
+		static void save(lua_State* L, const snapshot_player& p) {
+			lua_createtable(L, 2, 0);
+			stack::push(L, p.name);
+			lua_rawseti(L, -2, 1);
+			stack::push(L, p.level);
+			lua_rawseti(L, -2, 2);
+		}
+
+		static snapshot_player load(lua_State* L, int index) {
+			sol::table t(L, index);
+			return snapshot_player{ t[1], t[2] };
+		}
+	};
+}
+
+TEST_CASE("customization/serialize", "values and opted-in usertypes are written to bytes and read back, keeping shared references") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::math);
+	lua.new_usertype<snapshot_vec>("vec", "x", &snapshot_vec::x, "y", &snapshot_vec::y, "z", &snapshot_vec::z);
+	lua.new_usertype<snapshot_player>("player", "name", &snapshot_player::name, "level", &snapshot_player::level);
+	sol::register_serializer<snapshot_vec>(lua);
+	sol::register_serializer<snapshot_player>(lua);
+	lua["origin"] = snapshot_vec{ 1.5f, -2.0f, 3.0f };
+	lua["hero"] = snapshot_player{ "ana", 7 };
+	lua.script(R"(
+state = { tick = 1234, ratio = 0.125, paused = false, label = "lvl\0one", spawn = origin, home = origin, hero = hero, list = { 1, 2, 3 } }
+state.self = state
+)");
+	std::string bytes;
+	bytes.reserve(512);
+	sol::serialize(lua["state"], bytes);
+	REQUIRE_FALSE(bytes.empty());
+	std::size_t first = bytes.size();
+	sol::serialize(lua["state"], bytes);
+	REQUIRE(bytes.size() == first * 2);
+	bytes.resize(first);
+
+	sol::state other;
+	other.open_libraries(sol::lib::base, sol::lib::math);
+	other.new_usertype<snapshot_vec>("vec", "x", &snapshot_vec::x, "y", &snapshot_vec::y, "z", &snapshot_vec::z);
+	other.new_usertype<snapshot_player>("player", "name", &snapshot_player::name, "level", &snapshot_player::level);
+	sol::register_serializer<snapshot_vec>(other);
+	sol::register_serializer<snapshot_player>(other);
+	int top = lua_gettop(other);
+	other["state"] = sol::deserialize(other, bytes);
+	REQUIRE(lua_gettop(other) == top);
+	bool same = other.script(R"(
+return state.tick == 1234 and math.type(state.tick) == "integer" and state.ratio == 0.125 and state.paused == false
+	and state.label == "lvl\0one" and state.self == state and #state.list == 3
+	and state.spawn == state.home and state.spawn.y == -2 and state.hero.name == "ana" and state.hero.level == 7
+)");
+	REQUIRE(same);
+	snapshot_vec& spawn = other["state"]["spawn"];
+	spawn.x = 10.0f;
+	REQUIRE(other["state"]["home"]["x"] == 10.0f);
+	snapshot_vec& original = lua["origin"];
+	REQUIRE(original.x == 1.5f);
+
+	REQUIRE_THROWS(sol::deserialize(other, bytes.substr(0, bytes.size() / 2)));
+	REQUIRE(lua_gettop(other) == top);
+	// a table header whose two counts only fit the payload once their sum wraps around
+	std::string wrapped(1, '\x06');
+	for (int count = 0; count < 2; ++count) {
+		// 2^63 as a varint
+		wrapped.append(9, '\x80');
+		wrapped.push_back('\x01');
+	}
+	REQUIRE_THROWS(sol::deserialize(other, wrapped));
+	REQUIRE(lua_gettop(other) == top);
+	sol::state unregistered;
+	REQUIRE_THROWS(sol::deserialize(unregistered, bytes));
+	lua.script("bad = { f = print }");
+	std::string partial = "abc";
+	REQUIRE_THROWS(sol::serialize(lua["bad"], partial));
+	REQUIRE(partial == "abc");
+}
@@ -4,6 +4,10 @@
 #include <sol.hpp>
 #include <iostream>
 #include <fstream>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <algorithm>
 #include "test_stack_guard.hpp"
 
 TEST_CASE("state/require_file", "opening files as 'requires'") {
@@ -434,3 +438,336 @@ TEST_CASE("state/script-do-load", "test success and failure cases for loading an
 	}
 
 }
+
+TEST_CASE("state/reference_arena", "arena objects live in stack slots and are all released when the arena ends") {
+	sol::state lua;
+	lua.script("config = { width = 640, name = 'main', sub = { depth = 3 }, [2.5] = 'half', [true] = 'yes', [7] = 'seven' }");
+	sol::table config = lua["config"];
+	int top = lua_gettop(lua);
+	{
+		sol::reference_arena arena(lua, 8);
+		sol::stack_object width = arena.get(config, "width");
+		sol::stack_table sub = arena.get<sol::stack_table>(config, "sub");
+		sol::stack_object made = arena.make(std::string("made"));
+		REQUIRE(arena.size() == 3);
+		REQUIRE(width.as<int>() == 640);
+		REQUIRE(sub.get<int>("depth") == 3);
+		REQUIRE(made.as<std::string>() == "made");
+		{
+			sol::reference_arena inner(lua);
+			sol::stack_object name = inner.get(config, "name");
+			REQUIRE(name.as<std::string>() == "main");
+		}
+		REQUIRE(arena.size() == 3);
+		sol::stack_object half = arena.get(config, 2.5);
+		sol::stack_object yes = arena.get(config, true);
+		sol::stack_object seven = arena.get(config, sol::make_object(lua, 7));
+		REQUIRE(half.as<std::string>() == "half");
+		REQUIRE(yes.as<std::string>() == "yes");
+		REQUIRE(seven.as<std::string>() == "seven");
+		REQUIRE(arena.size() == 6);
+		arena.clear();
+		REQUIRE(arena.size() == 0);
+	}
+	REQUIRE(lua_gettop(lua) == top);
+}
+
+TEST_CASE("state/watch_global", "watched globals are cached in C++ until something assigns to them") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.script("speed = 10 function step(x) return x + 1 end");
+	sol::global_watch<int> speed = lua.watch_global<int>("speed");
+	sol::global_watch<sol::function> step = lua.watch_global<sol::function>("step");
+	int top = lua_gettop(lua);
+
+	REQUIRE(speed.get() == 10);
+	REQUIRE_FALSE(speed.stale());
+	REQUIRE(step.get().call<int>(1) == 2);
+
+	lua.script("speed = 20");
+	REQUIRE(speed.stale());
+	REQUIRE(speed.get() == 20);
+	lua["speed"] = 30;
+	REQUIRE(*speed == 30);
+	lua.script("step = function(x) return x * 2 end");
+	REQUIRE(step.get().call<int>(4) == 8);
+
+	int fromlua = lua.script("return speed");
+	REQUIRE(fromlua == 30);
+	int fromcpp = lua["speed"];
+	REQUIRE(fromcpp == 30);
+	lua.script("other = 5");
+	int other = lua["other"];
+	REQUIRE(other == 5);
+	REQUIRE_FALSE(speed.stale());
+	sol::global_watch<int> again = lua.watch_global<int>("speed");
+	REQUIRE(again.get() == 30);
+	REQUIRE(lua_gettop(lua) == top);
+
+	// adding to the metatable keeps the hooks; replacing it drops the watched globals, as documented
+	lua.script("getmetatable(_G).__call = function() return 1 end");
+	REQUIRE(lua.script("return speed").get<int>() == 30);
+	lua.script("setmetatable(_G, {})");
+	REQUIRE(lua.script("return speed == nil").get<bool>());
+	REQUIRE(speed.get() == 30);
+}
+
+TEST_CASE("state/state_pool", "jobs are spread over several states and their results come back through futures") {
+	std::atomic<int> initialized(0);
+	sol::state_pool pool(4, [&](sol::state& lua) {
+		lua.open_libraries(sol::lib::base);
+		lua.set_function("scale", [](int x) { return x * 10; });
+		++initialized;
+	}, R"(
+function handle(x, name)
+	return scale(x) + #name
+end
+function both(a, b)
+	return a + b, a * b
+end
+function broken()
+	error("bad request")
+end
+)");
+	REQUIRE(initialized == 4);
+	REQUIRE(pool.size() == 4);
+
+	std::vector<std::future<int>> results;
+	for (int i = 0; i < 200; ++i) {
+		results.push_back(pool.submit<int>("handle", i, std::string("abc")));
+	}
+	for (int i = 0; i < 200; ++i) {
+		REQUIRE(results[i].get() == i * 10 + 3);
+	}
+
+	std::future<std::tuple<int, int>> pair = pool.submit<std::tuple<int, int>>("both", 3, 4);
+	std::tuple<int, int> both = pair.get();
+	REQUIRE(std::get<0>(both) == 7);
+	REQUIRE(std::get<1>(both) == 12);
+
+	std::future<void> done = pool.submit("handle", 1, std::string(""));
+	done.get();
+	std::future<std::string> custom = pool.submit_with([](sol::state& lua) { return lua["handle"].call<int>(2, "xy") == 22 ? std::string("ok") : std::string("wrong"); });
+	REQUIRE(custom.get() == "ok");
+
+	std::future<void> fails = pool.submit("broken");
+	REQUIRE_THROWS(fails.get());
+	std::future<void> missing = pool.submit("no_such_function");
+	REQUIRE_THROWS(missing.get());
+
+	REQUIRE_THROWS(sol::state_pool(2, [](sol::state& lua) { lua.open_libraries(sol::lib::base); }, "error('bad setup')"));
+}
+
+TEST_CASE("state/transfer", "values are deep-copied between states, keeping cycles and shared tables") {
+	struct cargo {
+		int weight;
+	};
+
+	sol::state source;
+	sol::state target;
+	source.open_libraries(sol::lib::base);
+	target.open_libraries(sol::lib::base, sol::lib::math);
+	source.new_usertype<cargo>("cargo", "weight", &cargo::weight);
+	target.new_usertype<cargo>("cargo", "weight", &cargo::weight);
+	sol::register_transfer<cargo>(source);
+	source["box"] = cargo{ 12 };
+	source.script(R"(
+shared = { 1, 2, 3 }
+data = { name = "convoy", ratio = 0.5, count = 7, ok = true, a = shared, b = shared, [shared] = "key", box = box }
+data.self = data
+)");
+	int sourcetop = lua_gettop(source);
+	int targettop = lua_gettop(target);
+	sol::object copied = sol::transfer(source["data"], target);
+	REQUIRE(lua_gettop(source) == sourcetop);
+	REQUIRE(lua_gettop(target) == targettop);
+	REQUIRE(copied.lua_state() == target.lua_state());
+	target["data"] = copied;
+	bool same = target.script(R"(
+return data.name == "convoy" and data.ratio == 0.5 and math.type(data.count) == "integer"
+	and data.ok and data.self == data and data.a == data.b and #data.a == 3
+	and data[data.a] == "key" and data.box.weight == 12
+)");
+	REQUIRE(same);
+	target.script("data.a[1] = 100 data.box.weight = 1");
+	REQUIRE(source["shared"][1] == 1);
+	cargo& original = source["box"];
+	REQUIRE(original.weight == 12);
+
+	sol::object self = sol::transfer(source["data"], source);
+	source["copy"] = self;
+	REQUIRE(source.script("return copy ~= data and copy.self == copy and copy.a == copy.b").get<bool>());
+
+	source.script("bad = { f = print }");
+	REQUIRE_THROWS(sol::transfer(source["bad"], target));
+	REQUIRE(lua_gettop(source) == sourcetop);
+	REQUIRE(lua_gettop(target) == targettop);
+	sol::state unregistered;
+	unregistered.new_usertype<cargo>("cargo");
+	unregistered["box"] = cargo{ 3 };
+	REQUIRE_THROWS(sol::transfer(unregistered["box"], target));
+}
+
+TEST_CASE("state/channel", "channels carry encoded values between states and suspend coroutines while empty") {
+	sol::channel ch(4);
+	REQUIRE(ch.capacity() == 4);
+	sol::state sender;
+	sol::state receiver;
+	sender.open_libraries(sol::lib::base);
+	receiver.open_libraries(sol::lib::base, sol::lib::coroutine);
+	sender["ch"] = ch;
+	receiver["ch"] = ch;
+	sol::channel same = receiver["ch"];
+	REQUIRE(same == ch);
+
+	sender.script(R"(
+local t = { name = "msg", list = { 1, 2.5, "three" } }
+t.self = t
+ch:send(t)
+ch:send(42)
+ch:send(nil)
+)");
+	REQUIRE(ch.size() == 3);
+	bool correct = receiver.script(R"(
+local t = ch:receive()
+local ok, n = ch:try_receive()
+local ok2, none = ch:try_receive()
+local ok3 = ch:try_receive()
+return t.name == "msg" and t.self == t and t.list[3] == "three" and t.list[2] == 2.5
+	and ok and n == 42 and ok2 and none == nil and not ok3
+)");
+	REQUIRE(correct);
+	REQUIRE_THROWS(sender.script("ch:send(print)"));
+	REQUIRE(sender.script("return ch:try_send(1) and ch:try_send(2) and ch:try_send(3) and ch:try_send(4) and not ch:try_send(5)").get<bool>());
+	while (ch.try_receive(receiver)) {
+	}
+
+#if SOL_LUA_VERSION >= 503
+	sol::scheduler sched(receiver);
+	receiver.script(R"(
+total = 0
+function consume(n)
+	for i = 1, n do
+		total = total + ch:receive()
+	end
+end
+)");
+	sched.spawn(receiver["consume"], 3);
+	REQUIRE(sched.tick() == 1);
+	REQUIRE(sched.tick() == 1);
+	REQUIRE(sched.size() == 1);
+	sender.script("ch:send(1) ch:send(2)");
+	sched.tick();
+	REQUIRE(sched.size() == 1);
+	REQUIRE(ch.try_send(sol::make_object(sender, 3)));
+	sched.tick();
+	REQUIRE(sched.empty());
+	REQUIRE(receiver["total"] == 6);
+
+	receiver.script(R"(
+function produce()
+	for i = 1, 5 do
+		ch:send({ value = i })
+	end
+end
+)");
+	sched.spawn(receiver["produce"]);
+	sched.tick();
+	REQUIRE(sched.size() == 1);
+	REQUIRE(ch.size() == 4);
+	REQUIRE(receiver.script("return ch:receive().value").get<int>() == 1);
+	sched.tick();
+	REQUIRE(sched.empty());
+	REQUIRE(receiver.script("local t = 0 for i = 1, 4 do t = t + ch:receive().value end return t").get<int>() == 14);
+#endif
+
+	sol::channel work(64);
+	const int per_thread = 500;
+	std::vector<std::unique_ptr<sol::state>> states;
+	std::vector<std::thread> producers;
+	for (int t = 0; t < 3; ++t) {
+		states.emplace_back(new sol::state());
+		sol::state& lua = *states.back();
+		lua["ch"] = work;
+		lua["base"] = t * per_thread;
+	}
+	for (int t = 0; t < 3; ++t) {
+		producers.emplace_back([&states, t]() {
+			states[t]->script("for i = 1, " + std::to_string(per_thread) + " do ch:send(base + i) end");
+		});
+	}
+	long long sum = 0;
+	int received = 0;
+	while (received < 3 * per_thread) {
+		sol::optional<sol::object> value = work.try_receive(receiver);
+		if (value) {
+			sum += value->as<int>();
+			++received;
+		}
+	}
+	for (std::thread& producer : producers) {
+		producer.join();
+	}
+	long long n = 3 * per_thread;
+	REQUIRE(sum == n * (n + 1) / 2);
+}
+
+struct mapped_offset {
+	int by;
+};
+
+namespace sol {
+	template <>
+	struct usertype_serializer<mapped_offset> : trivial_usertype_serializer<mapped_offset> {};
+}
+
+TEST_CASE("state/parallel_map", "a Lua function is mapped over a range on worker states, with its upvalues copied") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::math);
+	lua.script(R"(
+local weights = { scale = 3, bonus = 1 }
+function score(x)
+	return x * weights.scale + math.floor(x / 2) + weights.bonus
+end
+function positive(x)
+	return x > 0
+end
+function picky(x)
+	if x == 77 then error("bad record") end
+	return x
+end
+local f = print
+function uses_c(x)
+	return f
+end
+)");
+	std::vector<int> records(1000);
+	for (int i = 0; i < 1000; ++i) {
+		records[i] = i - 10;
+	}
+	sol::state_pool pool(4, [](sol::state& worker) { worker.open_libraries(sol::lib::base, sol::lib::math); });
+	std::vector<long long> scores = sol::parallel_map<long long>(pool, lua["score"], records);
+	REQUIRE(scores.size() == records.size());
+	sol::function score = lua["score"];
+	for (std::size_t i = 0; i < records.size(); i += 37) {
+		long long expected = score(records[i]);
+		REQUIRE(scores[i] == expected);
+	}
+	std::vector<bool> signs = sol::parallel_map<bool>(pool, lua["positive"], records, 7);
+	REQUIRE(std::count(signs.begin(), signs.end(), true) == 989);
+
+	REQUIRE_THROWS(sol::parallel_map<int>(pool, lua["picky"], std::vector<int>{ 1, 77, 3 }));
+	REQUIRE_THROWS(sol::parallel_map<int>(pool, lua["uses_c"], records));
+	REQUIRE_THROWS(sol::parallel_map<int>(pool, lua["print"], records));
+	REQUIRE(sol::parallel_map<int>(pool, lua["picky"], std::vector<int>()).empty());
+
+	// the offset can be written in this state, but no worker knows how to read it back
+	lua.new_usertype<mapped_offset>("mapped_offset", "by", &mapped_offset::by);
+	sol::register_serializer<mapped_offset>(lua);
+	lua["offset"] = mapped_offset{ 5 };
+	lua.script("local o = offset function shifted(x) return x + (o and o.by or 0) end");
+	REQUIRE_THROWS(sol::parallel_map<int>(pool, lua["shifted"], std::vector<int>{ 1, 2 }));
+
+	std::vector<int> doubled = sol::parallel_map<int>(lua.script("return function(x) return x * 2 end").get<sol::function>(), std::vector<int>{ 1, 2, 3 }, 2);
+	REQUIRE(doubled == std::vector<int>{ 2, 4, 6 });
+}
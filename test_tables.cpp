@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <numeric>
 #include <vector>
+#include <map>
 
 #include "test_stack_guard.hpp"
 
@@ -577,9 +578,246 @@ TEST_CASE("tables/optional-move", "ensure pushing a sol::optional<T> rvalue corr
 	sol::state sol_state;
 	struct move_only{
 		int secret_code;
+		// C++20 no longer treats a class with declared constructors as an aggregate
+		move_only(int code) : secret_code(code) {}
 		move_only(const move_only&) = delete;
 		move_only(move_only&&) = default;
 	};
 	sol_state["requires_move"] = sol::optional<move_only>{move_only{0x4D}};
 	REQUIRE(sol_state["requires_move"].get<move_only>().secret_code == 0x4D);
 }
+
+TEST_CASE("tables/array_view", "array_view and table_view arguments read from the table on demand instead of copying it") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	lua.set_function("sum", [](sol::array_view<int> v) {
+		int s = 0;
+		for (int x : v) {
+			s += x;
+		}
+		return s;
+	});
+	lua.set_function("second", [](sol::array_view<std::string> v) {
+		return v.size() > 1 ? v[1] : std::string();
+	});
+	lua.set_function("lookup", [](sol::table_view<std::string, int> t, std::string key) {
+		sol::optional<int> v = t.get(key);
+		return v ? *v : -1;
+	});
+	lua.set_function("count", [](sol::table_view<std::string, int> t) {
+		int n = 0;
+		t.for_each([&n](std::string, int v) {
+			n += v;
+		});
+		return n;
+	});
+
+	lua.script(R"(
+s = sum({ 1, 2, 3, 4 })
+n = second({ "a", "b", "c" })
+empty = second({})
+l = lookup({ a = 1, b = 2 }, "b")
+m = lookup({ a = 1, b = 2 }, "c")
+c = count({ a = 1, b = 2, c = 3 })
+)");
+	int s = lua["s"];
+	std::string n = lua["n"];
+	std::string empty = lua["empty"];
+	int l = lua["l"];
+	int m = lua["m"];
+	int c = lua["c"];
+	REQUIRE(s == 10);
+	REQUIRE(n == "b");
+	REQUIRE(empty.empty());
+	REQUIRE(l == 2);
+	REQUIRE(m == -1);
+	REQUIRE(c == 6);
+
+	int begintop = 0, endtop = 0;
+	{
+		test_stack_guard g(lua.lua_state(), begintop, endtop);
+		int v = lua["sum"](sol::as_table(std::vector<int>{ 5, 6 }));
+		REQUIRE(v == 11);
+	}
+	REQUIRE(begintop == endtop);
+	REQUIRE_THROWS([&]() {
+		lua.script("sum(5)");
+	}());
+}
+
+TEST_CASE("tables/for_each-typed", "typed for_each and for_each_array hand values straight from the stack to the callback") {
+	sol::state lua;
+	lua.script(R"(
+t = { 10, 20, 30, x = 1, y = "two", [4.5] = 3 }
+)");
+	sol::table t = lua["t"];
+	int begintop = 0, endtop = 0;
+	{
+		test_stack_guard g(lua.lua_state(), begintop, endtop);
+		int ints = 0;
+		t.for_each<std::string, int>([&](std::string k, int v) {
+			REQUIRE(k == "x");
+			ints += v;
+		});
+		REQUIRE(ints == 1);
+
+		std::size_t keys = 0;
+		t.for_each<sol::stack_proxy, sol::stack_proxy>([&](sol::stack_proxy k, sol::stack_proxy v) {
+			++keys;
+			if (k.get<sol::type>() == sol::type::string && k.get<std::string>() == "y") {
+				REQUIRE(v.get<std::string>() == "two");
+			}
+		});
+		REQUIRE(keys == 6);
+
+		std::vector<int> values;
+		t.for_each_array<int>([&](std::size_t i, int v) {
+			REQUIRE(v == static_cast<int>(i) * 10);
+			values.push_back(v);
+		});
+		REQUIRE(values.size() == 3);
+	}
+	REQUIRE(begintop == endtop);
+}
+
+TEST_CASE("tables/pairs-view", "iterating with pairs() yields stack-backed key/value views instead of objects") {
+	sol::state lua;
+	lua.script("t = { 1, 2, 3, x = 'a', y = 'b' }");
+	sol::table t = lua["t"];
+	int begintop = 0, endtop = 0;
+	{
+		test_stack_guard g(lua.lua_state(), begintop, endtop);
+		int sum = 0;
+		std::size_t count = 0;
+		sol::object kept;
+		for (auto& kv : t.pairs()) {
+			++count;
+			if (kv.second.get<sol::type>() == sol::type::number) {
+				sum += kv.second.get<int>();
+			}
+			else if (kv.first.get<sol::type>() == sol::type::string && kv.first.get<std::string>() == "y") {
+				kept = kv.second;
+			}
+		}
+		REQUIRE(count == 5);
+		REQUIRE(sum == 6);
+		REQUIRE(kept.as<std::string>() == "b");
+
+		for (auto& kv : t.pairs()) {
+			(void)kv;
+			break;
+		}
+	}
+	REQUIRE(begintop == endtop);
+}
+
+TEST_CASE("tables/key_path", "precompiled key paths resolve a whole chain of keys in one call") {
+	sol::state lua;
+	lua.script(R"(
+cfg = { render = { shadows = { cascade_count = 4 }, name = "fast" } }
+)");
+	sol::key_path cascades(lua, "cfg", "render", "shadows", "cascade_count");
+	sol::key_path missing(lua, "cfg", "render", "lights", "count");
+	sol::key_path through_value(lua, "render", "name", "length");
+	sol::table cfg = lua["cfg"];
+	int begintop = 0, endtop = 0;
+	{
+		test_stack_guard g(lua.lua_state(), begintop, endtop);
+		int n = cascades.get<int>(lua);
+		REQUIRE(n == 4);
+		sol::optional<int> no = missing.get<sol::optional<int>>(lua);
+		REQUIRE_FALSE(static_cast<bool>(no));
+		sol::optional<int> through = through_value.get<sol::optional<int>>(cfg);
+		REQUIRE_FALSE(static_cast<bool>(through));
+
+		lua.script("cfg.render.shadows.cascade_count = 2");
+		int changed = cascades.get<int>(lua);
+		REQUIRE(changed == 2);
+	}
+	REQUIRE(begintop == endtop);
+}
+
+TEST_CASE("tables/interned_key", "interned keys work anywhere a string key does") {
+	sol::state lua;
+	sol::interned_key speed(lua, "speed");
+	sol::interned_key player(lua, std::string("player"));
+	REQUIRE(speed.str() == "speed");
+
+	lua.create_named_table("player");
+	sol::table p = lua[player];
+	p.set(speed, 20);
+	int s = p.get<int>(speed);
+	REQUIRE(s == 20);
+	int through = lua.traverse_get<int>(player, speed);
+	REQUIRE(through == 20);
+	lua[player][speed] = 30;
+	int fromlua = lua.script("return player.speed");
+	REQUIRE(fromlua == 30);
+	sol::optional<int> missing = p.get<sol::optional<int>>(sol::interned_key(lua, "missing"));
+	REQUIRE_FALSE(static_cast<bool>(missing));
+}
+
+TEST_CASE("tables/create_from", "tables built from C++ ranges get every element and skip metamethods on assign") {
+	sol::state lua;
+	std::map<std::string, int> names{ { "a", 1 }, { "b", 2 }, { "c", 3 } };
+	std::map<int, std::string> sparse{ { 1, "x" }, { 2, "y" }, { 10, "z" } };
+	std::vector<double> values{ 0.5, 1.5, 2.5 };
+
+	int begintop = 0, endtop = 0;
+	{
+		test_stack_guard g(lua.lua_state(), begintop, endtop);
+		sol::table t = lua.create_table_from(names);
+		REQUIRE(t.get<int>("b") == 2);
+		sol::table s = lua.create_table_from(sparse);
+		REQUIRE(s.get<std::string>(1) == "x");
+		REQUIRE(s.get<std::string>(10) == "z");
+		sol::table v = lua.create_table_from(values);
+		REQUIRE(v.size() == 3);
+		REQUIRE(v.get<double>(3) == 2.5);
+	}
+	REQUIRE(begintop == endtop);
+
+	lua.open_libraries(sol::lib::base);
+	lua.script("guarded = setmetatable({}, { __newindex = function() error('newindex called') end })");
+	sol::table guarded = lua["guarded"];
+	REQUIRE_NOTHROW(guarded.assign(names).assign(values));
+	int b = lua.script("return guarded.b");
+	REQUIRE(b == 2);
+	double second = lua.script("return guarded[2]");
+	REQUIRE(second == 1.5);
+}
+
+TEST_CASE("tables/observable", "observable tables record which keys scripts assign to") {
+	sol::state lua;
+	lua.open_libraries(sol::lib::base);
+	sol::observable_table state = lua.create_observable_table("state");
+	state.backing().set("hp", 100, "mp", 50, 1, "first");
+	REQUIRE_FALSE(state.dirty());
+
+	lua.script("assert(state.hp == 100) state.hp = state.hp - 10 state.hp = state.hp - 10 state.name = 'bob'");
+#if SOL_LUA_VERSION > 501
+	lua.script("assert(#state == 1) local n = 0 for k, v in pairs(state) do n = n + 1 end assert(n == 4)");
+#endif
+	REQUIRE(state.dirty_count() == 2);
+	REQUIRE(state.get<int>("hp") == 80);
+
+	std::map<std::string, sol::object> changed;
+	int begintop = 0, endtop = 0;
+	{
+		test_stack_guard g(lua.lua_state(), begintop, endtop);
+		state.sync<std::string>([&](std::string key, sol::object value) {
+			changed.emplace(key, value);
+		});
+	}
+	REQUIRE(begintop == endtop);
+	REQUIRE(changed.size() == 2);
+	REQUIRE(changed["hp"].as<int>() == 80);
+	REQUIRE(changed["name"].as<std::string>() == "bob");
+	REQUIRE_FALSE(state.dirty());
+
+	state["mp"] = 0;
+	std::size_t n = 0;
+	state.for_each_dirty([&](sol::object key, sol::object) { REQUIRE(key.as<std::string>() == "mp"); ++n; });
+	REQUIRE(n == 1);
+	REQUIRE(state.dirty_count() == 1);
+}